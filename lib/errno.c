@@ -0,0 +1,9 @@
+// GPLv2
+
+int __symbiotic_errno = 0;
+int * __attribute__((weak)) __errno_location(void)
+{
+	/* we don't support multi-threaded programs,
+	 * so we can have just this one errno */
+	return &__symbiotic_errno;
+}
@@ -0,0 +1,10 @@
+// GPLv2
+
+#include "lib.h"
+
+void *kzalloc(int size, int gfp)
+{
+	(void) gfp;
+	extern void *malloc(size_t size);
+	return malloc(size);
+}
@@ -0,0 +1,30 @@
+// GPLv2
+
+/* types and klee functions shared by the parts of the runtime */
+#ifndef SVC15_LIB_H
+#define SVC15_LIB_H
+
+#ifdef __UINT32_TYPE__
+typedef __UINT32_TYPE__ u_int32_t;
+typedef __UINT32_TYPE__ uint32_t;
+#else
+typedef	unsigned int u_int32_t; //klee-uclibc/include/sys/types.h
+typedef unsigned int uint32_t; //stdint.h
+#endif
+
+#ifdef __SIZE_TYPE__
+typedef __SIZE_TYPE__ size_t;
+#else
+#if __x86_64__
+typedef unsigned long int size_t;
+#else
+typedef unsigned int size_t;
+#endif
+#endif
+
+typedef unsigned long uintptr_t;
+
+void klee_make_symbolic(void *addr, size_t nbytes, const char *name);
+void klee_assume(uintptr_t condition);
+
+#endif /* SVC15_LIB_H */
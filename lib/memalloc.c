@@ -1,72 +1,138 @@
 // GPLv2
 
-#ifdef __UINT32_TYPE__
-typedef __UINT32_TYPE__ u_int32_t;
-typedef __UINT32_TYPE__ uint32_t;
-#else
-typedef	unsigned int u_int32_t; //klee-uclibc/include/sys/types.h
-typedef unsigned int uint32_t; //stdint.h
-#endif
+#include "lib.h"
 
-#ifdef __SIZE_TYPE__
-typedef __SIZE_TYPE__ size_t;
-#else
-#if __x86_64__
-typedef unsigned long int size_t;
+void *malloc(size_t size);
+void *calloc(size_t nmem, size_t size);
+void free(void *ptr);
+void *realloc(void *ptr, size_t size);
+void *memset(void *s, int c, size_t n);
+
+_Bool __VERIFIER_nondet__Bool(void);
+/* keeps the objects for __VERIFIER_nondet_pointer (lib.c) */
+void __symbiotic_register_pointer(void *mem);
+void __symbiotic_unregister_pointer(void *mem);
+
+/* the never-failing flavor of the runtime is compiled with
+ * SVC15_ALLOC_NEVER_FAILS, then even the functions
+ * that may return NULL always succeed */
+#ifdef SVC15_ALLOC_NEVER_FAILS
+#define ALLOC_FAILS() 0
 #else
-typedef unsigned int size_t;
+#define ALLOC_FAILS() __VERIFIER_nondet__Bool()
 #endif
-#endif
-
-_Bool __VERIFIER_nondet__Bool();
 
 /* add our own versions of malloc and calloc */
+/* the name is the id of the allocation site that instrument-alloc
+ * gives us (e.g. "malloc:3"), we use it for the symbolic memory */
 /* non-deterministically return memory or NULL */
-void *__VERIFIER_malloc(size_t size)
+void *__VERIFIER_malloc(size_t size, const char *name)
 {
-	if (__VERIFIER_nondet__Bool())
+	if (ALLOC_FAILS())
 		return ((void *) 0);
 
 	void *mem = malloc(size);
-	klee_make_symbolic(mem, size, "malloc");
+	klee_make_symbolic(mem, size, name);
+	__symbiotic_register_pointer(mem);
 
 	return mem;
 }
 
-void *memset(void *s, int c, size_t n);
-void *__VERIFIER_calloc(size_t nmem, size_t size)
+/* versions for memory that is overwritten before it is read,
+ * so there is no need to make it symbolic */
+void *__VERIFIER_malloc_concrete(size_t size, const char *name)
 {
-	if (__VERIFIER_nondet__Bool())
+	if (ALLOC_FAILS())
 		return ((void *) 0);
 
-	void *mem = malloc(nmem * size);
-	/* do it symbolic, so that subsequent
-	 * uses will be symbolic, but initialize it
-	 * to 0s */
-	klee_make_symbolic(mem, nmem * size, "calloc");
-	memset(mem, 0, nmem * size);
+	void *mem = malloc(size);
+	__symbiotic_register_pointer(mem);
+
+	return mem;
+}
+
+void *__VERIFIER_malloc0_concrete(size_t size, const char *name)
+{
+	void *mem = malloc(size);
+	__symbiotic_register_pointer(mem);
+
+	return mem;
+}
+
+/* klee allocates the memory for calloc zeroed,
+ * so we do not need any symbolic array or stores */
+void *__VERIFIER_calloc(size_t nmem, size_t size, const char *name)
+{
+	if (ALLOC_FAILS())
+		return ((void *) 0);
+
+	void *mem = calloc(nmem, size);
+	__symbiotic_register_pointer(mem);
 
 	return mem;
 }
 
 /* this versions never return NULL */
-void *__VERIFIER_malloc0(size_t size)
+void *__VERIFIER_malloc0(size_t size, const char *name)
 {
 	void *mem = malloc(size);
 	// NOTE: klee already assumes that
 	//klee_assume(mem != (void *) 0);
-	klee_make_symbolic(mem, size, "malloc0");
+	klee_make_symbolic(mem, size, name);
+	__symbiotic_register_pointer(mem);
+
+	return mem;
+}
+
+void *__VERIFIER_calloc0(size_t nmem, size_t size, const char *name)
+{
+	void *mem = calloc(nmem, size);
+	__symbiotic_register_pointer(mem);
 
 	return mem;
 }
 
-void *__VERIFIER_calloc0(size_t nmem, size_t size)
+/* these versions are used with -symbolic-calloc. The memory is
+ * symbolic and then initialized to 0s, so that slicer can remove
+ * the initialization if the program overwrites the memory anyway */
+void *__VERIFIER_calloc_symbolic(size_t nmem, size_t size, const char *name)
 {
+	if (ALLOC_FAILS())
+		return ((void *) 0);
+
 	void *mem = malloc(nmem * size);
-	//klee_assume(mem != (void *) 0);
-	klee_make_symbolic(mem, nmem * size, "calloc0");
+	klee_make_symbolic(mem, nmem * size, name);
+	memset(mem, 0, nmem * size);
+	__symbiotic_register_pointer(mem);
+
+	return mem;
+}
+
+void *__VERIFIER_calloc0_symbolic(size_t nmem, size_t size, const char *name)
+{
+	void *mem = malloc(nmem * size);
+	klee_make_symbolic(mem, nmem * size, name);
 	memset(mem, 0, nmem * size);
+	__symbiotic_register_pointer(mem);
 
 	return mem;
 }
 
+/* instrument-alloc redirects free and realloc here, so that
+ * the freed objects are no longer returned as nondet pointers */
+void __VERIFIER_free(void *ptr)
+{
+	__symbiotic_unregister_pointer(ptr);
+	free(ptr);
+}
+
+void *__VERIFIER_realloc(void *ptr, size_t size)
+{
+	void *mem;
+
+	__symbiotic_unregister_pointer(ptr);
+	mem = realloc(ptr, size);
+	__symbiotic_register_pointer(mem);
+
+	return mem;
+}
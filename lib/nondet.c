@@ -0,0 +1,90 @@
+// GPLv2
+
+#include "lib.h"
+
+#define MAKE_NONDET(type)				\
+type __VERIFIER_nondet_ ## type(void)			\
+{							\
+	type x;						\
+	klee_make_symbolic(&x, sizeof(x), # type);	\
+	return x;					\
+}
+
+MAKE_NONDET(char);
+MAKE_NONDET(short);
+MAKE_NONDET(int);
+MAKE_NONDET(long);
+MAKE_NONDET(float);
+MAKE_NONDET(double);
+MAKE_NONDET(_Bool);
+
+_Bool __VERIFIER_nondet_bool(void)
+{
+	return __VERIFIER_nondet__Bool();
+}
+
+#undef MAKE_NONDET
+
+#define MAKE_NONDET(type)				\
+type nondet_ ## type(void)				\
+{							\
+	return __VERIFIER_nondet_ ## type();		\
+}
+
+MAKE_NONDET(char);
+MAKE_NONDET(short);
+MAKE_NONDET(int);
+MAKE_NONDET(long);
+
+#undef MAKE_NONDET
+
+#define MAKE_NONDET(type)				\
+type __VERIFIER_nondet_u ## type(void)			\
+{							\
+	return __VERIFIER_nondet_ ## type();		\
+}
+
+MAKE_NONDET(char);
+MAKE_NONDET(short);
+MAKE_NONDET(int);
+MAKE_NONDET(long);
+
+#undef MAKE_NONDET
+
+/* these are crippled */
+
+unsigned int __VERIFIER_nondet_u32()
+{
+	return __VERIFIER_nondet_uint();
+}
+
+unsigned int __VERIFIER_nondet_U32()
+{
+	return __VERIFIER_nondet_uint();
+}
+
+unsigned int __VERIFIER_nondet_u8()
+{
+	return __VERIFIER_nondet_uchar();
+}
+
+/* these type are not sane, but benchmarks use them */
+unsigned int __VERIFIER_nondet_U8()
+{
+	return __VERIFIER_nondet_uchar();
+}
+
+unsigned int __VERIFIER_nondet_u16()
+{
+	return __VERIFIER_nondet_ushort();
+}
+
+unsigned int __VERIFIER_nondet_U16()
+{
+	return __VERIFIER_nondet_ushort();
+}
+
+unsigned int __VERIFIER_nondet_unsigned()
+{
+	return __VERIFIER_nondet_uint();
+}
@@ -0,0 +1,73 @@
+// GPLv2
+
+#include "lib.h"
+
+extern void *malloc(size_t);
+int __VERIFIER_nondet_uint(void);
+
+/* Fully symbolic pointer would make klee resolve every dereference
+ * against all objects in memory. Instead, the nondet pointer is NULL,
+ * a fresh symbolic object or one of the last allocated objects
+ * that were not freed yet, so that it costs a fixed number of forks */
+#ifndef SVC15_NONDET_POINTER_SIZE
+#define SVC15_NONDET_POINTER_SIZE 64
+#endif
+
+#ifndef SVC15_POINTER_REGISTRY_SIZE
+#define SVC15_POINTER_REGISTRY_SIZE 4
+#endif
+
+static void *__symbiotic_pointer_registry[SVC15_POINTER_REGISTRY_SIZE];
+static unsigned __symbiotic_pointer_registry_next = 0;
+
+/* called by the allocation models from memalloc.c */
+void __symbiotic_register_pointer(void *mem)
+{
+	if (!mem)
+		return;
+
+	__symbiotic_pointer_registry[__symbiotic_pointer_registry_next
+				     % SVC15_POINTER_REGISTRY_SIZE] = mem;
+	++__symbiotic_pointer_registry_next;
+}
+
+/* called by the models of free and realloc (memalloc.c), so that
+ * we never return a dangling pointer from __VERIFIER_nondet_pointer */
+void __symbiotic_unregister_pointer(void *mem)
+{
+	unsigned i;
+
+	if (!mem)
+		return;
+
+	for (i = 0; i < SVC15_POINTER_REGISTRY_SIZE; ++i)
+		if (__symbiotic_pointer_registry[i] == mem)
+			__symbiotic_pointer_registry[i] = ((void *) 0);
+}
+
+void *__VERIFIER_nondet_pointer()
+{
+	unsigned registered = __symbiotic_pointer_registry_next;
+	unsigned choice = __VERIFIER_nondet_uint();
+	unsigned i;
+
+	if (registered > SVC15_POINTER_REGISTRY_SIZE)
+		registered = SVC15_POINTER_REGISTRY_SIZE;
+
+	if (choice == 0)
+		return ((void *) 0);
+
+	for (i = 0; i < registered; ++i)
+		if (choice == i + 1)
+			return __symbiotic_pointer_registry[i];
+
+	void *mem = malloc(SVC15_NONDET_POINTER_SIZE);
+	klee_make_symbolic(mem, SVC15_NONDET_POINTER_SIZE, "void*");
+
+	return mem;
+}
+
+char *__VERIFIER_nondet_pchar()
+{
+	return __VERIFIER_nondet_pointer();
+}
@@ -0,0 +1,26 @@
+// GPLv2
+
+#include "lib.h"
+
+size_t __attribute__((weak)) strlen(const char *str)
+{
+	size_t len = 0;
+	while (*str) {
+		++len;
+		++str;
+	}
+
+	return len;
+}
+
+extern void *malloc(size_t);
+extern void *memcpy(void *dest, const void *src, size_t n);
+
+char * __attribute__((weak)) strdup(const char *str)
+{
+	size_t len = strlen(str);
+	char *mem = malloc(len);
+	memcpy(mem, str, len);
+
+	return mem;
+}
@@ -0,0 +1,27 @@
+// GPLv2
+
+#include "lib.h"
+
+extern void __VERIFIER_error(void);
+
+extern void __assert_fail (__const char *__assertion, __const char *__file,
+			   unsigned int __line, __const char *__function);
+
+void __VERIFIER_error(void)
+{
+	/* FILE and LINE will be wrong, but that doesn't matter, klee will
+	   replace this call by its own handler anyway */
+	__assert_fail("verifier assertion failed", __FILE__, __LINE__, __func__);
+}
+
+void __VERIFIER_assert(int expr) __attribute__((weak));
+void __VERIFIER_assert(int expr)
+{
+	if (!expr)
+		__assert_fail("verifier assertion failed", __FILE__, __LINE__, __func__);
+}
+
+void __VERIFIER_assume(int expr)
+{
+	klee_assume(expr);
+}
@@ -0,0 +1,79 @@
+#!/bin/sh
+# Compare the default calloc model with -symbolic-calloc on large callocs.
+#
+# usage: bench-calloc.sh [-o results] LLVMsvc15.so lib-dir [size...]
+#
+# lib-dir is the directory with installed lib.c and memalloc.c.
+# Needs clang, llvm-link, opt, klee and GNU time. Memory is the maximal
+# resident set size of klee. With -o, the table is written also to
+# the results file together with the date and the versions of the tools,
+# so that the numbers can be recorded next to the change they measure.
+
+set -e
+
+RESULTS=/dev/null
+if [ "$1" = "-o" ]; then
+	RESULTS="$2"
+	shift 2
+fi
+
+if [ $# -lt 2 ]; then
+	echo "usage: $0 [-o results] LLVMsvc15.so lib-dir [size...]" >&2
+	exit 1
+fi
+
+PASSES="$1"
+LIBDIR="$2"
+shift 2
+SIZES="${*:-1024 65536 1048576}"
+
+TMP=`mktemp -d`
+trap 'rm -rf "$TMP"' EXIT
+
+cat > "$TMP/calloc.c" <<'EOC'
+extern void *calloc(unsigned long, unsigned long);
+extern void __VERIFIER_error(void);
+
+int main(void)
+{
+	unsigned char *mem = calloc(SIZE, 1);
+	if (mem && mem[SIZE / 2] != 0)
+		__VERIFIER_error();
+	return 0;
+}
+EOC
+
+clang -emit-llvm -c "$LIBDIR/lib.c" -o "$TMP/lib.bc"
+clang -emit-llvm -c "$LIBDIR/memalloc.c" -o "$TMP/memalloc.bc"
+
+{
+	echo "# `date -u '+%Y-%m-%d %H:%M'` `klee --version 2>&1 | head -n 1`"
+	echo "# `clang --version | head -n 1`"
+} > "$RESULTS"
+
+printf '%-10s %-10s %15s %15s\n' size mode instructions memory | tee -a "$RESULTS"
+for SIZE in $SIZES; do
+	clang -emit-llvm -c -DSIZE=$SIZE "$TMP/calloc.c" -o "$TMP/prog.bc"
+	for MODE in default symbolic; do
+		OPTS="-instrument-alloc"
+		if [ "$MODE" = symbolic ]; then
+			OPTS="$OPTS -symbolic-calloc"
+		fi
+
+		opt -load "$PASSES" $OPTS "$TMP/prog.bc" -o "$TMP/inst.bc"
+		llvm-link "$TMP/inst.bc" "$TMP/lib.bc" "$TMP/memalloc.bc" -o "$TMP/linked.bc"
+
+		rm -rf "$TMP/klee-$MODE"
+		/usr/bin/time -f %M -o "$TMP/rss" \
+			klee -output-dir="$TMP/klee-$MODE" "$TMP/linked.bc" >/dev/null 2>&1 || true
+
+		if [ -f "$TMP/klee-$MODE/info" ]; then
+			INSTRS=`sed -n 's/.*total instructions = \([0-9]*\).*/\1/p' "$TMP/klee-$MODE/info"`
+			MEM="`tail -n 1 "$TMP/rss"`kB"
+		else
+			INSTRS=failed
+			MEM=-
+		fi
+		printf '%-10s %-10s %15s %15s\n' "$SIZE" "$MODE" "$INSTRS" "$MEM" | tee -a "$RESULTS"
+	done
+done
@@ -0,0 +1,295 @@
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+
+// Load bitcode lazily and materialize only functions that are reachable
+// from the entry function. Bodies of the other functions are never parsed
+// and the functions are dropped from the output, so memory and load time
+// of the following svc15 passes scale with the reachable program only.
+
+#include <set>
+#include <vector>
+
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/GlobalAlias.h"
+#include "llvm/IR/GlobalVariable.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IRReader/IRReader.h"
+#include "llvm/Bitcode/ReaderWriter.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/ToolOutputFile.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace llvm;
+
+static cl::opt<std::string> InputFilename(cl::Positional,
+                                          cl::desc("<input bitcode file>"),
+                                          cl::init("-"),
+                                          cl::value_desc("filename"));
+
+static cl::opt<std::string> OutputFilename("o",
+                                           cl::desc("Specify output filename"),
+                                           cl::value_desc("filename"),
+                                           cl::init("-"));
+
+static cl::opt<std::string> EntryFunction("entry",
+                                          cl::desc("Function the reachability starts from"),
+                                          cl::init("main"));
+
+static cl::list<std::string> KeepFunctions("keep",
+                                           cl::desc("Keep also this function and what it reaches (can be repeated)"),
+                                           cl::value_desc("function"),
+                                           cl::ZeroOrMore);
+
+// the svc15 passes that run after us insert calls of these functions
+// (the models from lib/ if they are linked in already), so they are
+// reachable even though the program does not call them (yet)
+static const char *root_function_prefixes[] = {
+  "__VERIFIER_malloc",
+  "__VERIFIER_calloc",
+  "__VERIFIER_free",
+  "__VERIFIER_realloc",
+  "klee_make_symbolic",
+  "klee_assume",
+  NULL
+};
+
+// globals whose initializers are used by the code generator or KLEE
+// even though nothing in the program refers to them
+static const char *root_globals[] = {
+  "llvm.global_ctors",
+  "llvm.global_dtors",
+  "llvm.used",
+  "llvm.compiler.used",
+  NULL
+};
+
+static bool materialize(GlobalValue *GV)
+{
+  if (!GV->isMaterializable())
+    return true;
+
+#if (LLVM_VERSION_MINOR < 6)
+  std::string ErrInfo;
+  if (GV->Materialize(&ErrInfo)) {
+    errs() << "LazyPrepare: error reading '" << GV->getName()
+           << "': " << ErrInfo << "\n";
+    return false;
+  }
+#else
+  if (std::error_code EC = GV->materialize()) {
+    errs() << "LazyPrepare: error reading '" << GV->getName()
+           << "': " << EC.message() << "\n";
+    return false;
+  }
+#endif
+
+  return true;
+}
+
+class Reachability {
+  std::set<const Constant *> visited;
+  std::vector<GlobalValue *> worklist;
+
+  void addConstant(Constant *C);
+  void addValue(Value *V);
+
+  public:
+    std::set<Function *> functions;
+
+    void addRoot(GlobalValue *GV) { addConstant(GV); }
+    bool run();
+};
+
+void Reachability::addConstant(Constant *C)
+{
+  if (!visited.insert(C).second)
+    return;
+
+  if (GlobalValue *GV = dyn_cast<GlobalValue>(C)) {
+    worklist.push_back(GV);
+    return;
+  }
+
+  // constant expressions and aggregates (e.g. tables of function pointers)
+  for (User::op_iterator I = C->op_begin(), E = C->op_end(); I != E; ++I)
+    if (Constant *Op = dyn_cast<Constant>(*I))
+      addConstant(Op);
+}
+
+void Reachability::addValue(Value *V)
+{
+  if (Constant *C = dyn_cast<Constant>(V))
+    addConstant(C);
+}
+
+bool Reachability::run()
+{
+  while (!worklist.empty()) {
+    GlobalValue *GV = worklist.back();
+    worklist.pop_back();
+
+    if (GlobalVariable *GVar = dyn_cast<GlobalVariable>(GV)) {
+      if (GVar->hasInitializer())
+        addConstant(GVar->getInitializer());
+      continue;
+    }
+
+    if (GlobalAlias *GA = dyn_cast<GlobalAlias>(GV)) {
+      addConstant(GA->getAliasee());
+      continue;
+    }
+
+    Function *F = cast<Function>(GV);
+    functions.insert(F);
+
+    // this is the only place where we parse a function body
+    if (!materialize(F))
+      return false;
+
+    // every constant operand is a potential call-graph edge: direct
+    // calls as well as functions whose address is taken (and may be
+    // called indirectly later) and globals that may hold such addresses
+    for (Function::iterator B = F->begin(), BE = F->end(); B != BE; ++B)
+      for (BasicBlock::iterator I = B->begin(), IE = B->end(); I != IE; ++I)
+        for (User::op_iterator O = I->op_begin(), OE = I->op_end(); O != OE; ++O)
+          addValue(*O);
+  }
+
+  return true;
+}
+
+int main(int argc, char **argv)
+{
+  llvm_shutdown_obj Y;
+  LLVMContext &Context = getGlobalContext();
+  cl::ParseCommandLineOptions(argc, argv,
+                              "lazily load only the part of the module reachable from main\n");
+
+  SMDiagnostic Err;
+#if (LLVM_VERSION_MINOR < 6)
+  Module *M = getLazyIRFileModule(InputFilename, Err, Context);
+#else
+  std::unique_ptr<Module> M = getLazyIRFileModule(InputFilename, Err, Context);
+#endif
+  if (!M) {
+    Err.print(argv[0], errs());
+    return 1;
+  }
+
+  Function *entry = M->getFunction(EntryFunction);
+  if (!entry) {
+    errs() << "LazyPrepare: no function '" << EntryFunction << "' in module\n";
+    return 1;
+  }
+
+  Reachability R;
+  R.addRoot(entry);
+  for (const char **curr = root_globals; *curr; curr++)
+    if (GlobalVariable *GV = M->getNamedGlobal(*curr))
+      R.addRoot(GV);
+
+  for (unsigned i = 0; i < KeepFunctions.size(); ++i) {
+    if (Function *F = M->getFunction(KeepFunctions[i]))
+      R.addRoot(F);
+    else
+      errs() << "LazyPrepare: no function '" << KeepFunctions[i]
+             << "' to keep in module\n";
+  }
+
+  for (Module::iterator I = M->begin(), E = M->end(); I != E; ++I)
+    for (const char **curr = root_function_prefixes; *curr; curr++)
+      if (I->getName().startswith(*curr))
+        R.addRoot(&*I);
+
+  if (!R.run())
+    return 1;
+
+  // aliases of the functions that we drop are not reachable either
+  // (or the aliasee would be), drop them first so that they do not
+  // end up pointing to null
+  for (Module::alias_iterator I = M->alias_begin(), E = M->alias_end(); I != E;) {
+    GlobalAlias *GA = &*I;
+    ++I;
+
+    Function *F = dyn_cast<Function>(GA->getAliasee()->stripPointerCasts());
+    if (!F || R.functions.count(F))
+      continue;
+
+    if (!GA->use_empty())
+      GA->replaceAllUsesWith(Constant::getNullValue(GA->getType()));
+    GA->eraseFromParent();
+  }
+
+  // drop everything that was not reached. The remaining uses of these
+  // functions can come only from initializers of unreachable globals
+  unsigned total = 0, dropped = 0;
+  for (Module::iterator I = M->begin(), E = M->end(); I != E;) {
+    Function *F = &*I;
+    ++I;
+    ++total;
+
+    if (R.functions.count(F))
+      continue;
+
+    if (!F->use_empty())
+      F->replaceAllUsesWith(Constant::getNullValue(F->getType()));
+    F->eraseFromParent();
+    ++dropped;
+  }
+
+  errs() << "LazyPrepare: materialized " << (total - dropped) << " of "
+         << total << " functions\n";
+
+  // only no-op now, but the writer requires fully read module
+#if (LLVM_VERSION_MINOR < 5)
+  std::string ErrInfo;
+  if (M->MaterializeAll(&ErrInfo)) {
+    errs() << "LazyPrepare: error reading module: " << ErrInfo << "\n";
+    return 1;
+  }
+#else
+  if (std::error_code EC = M->materializeAll()) {
+    errs() << "LazyPrepare: error reading module: " << EC.message() << "\n";
+    return 1;
+  }
+#endif
+
+#if (LLVM_VERSION_MINOR < 5)
+  std::string ErrorInfo;
+  tool_output_file Out(OutputFilename.c_str(), ErrorInfo, sys::fs::F_Binary);
+  if (!ErrorInfo.empty()) {
+    errs() << ErrorInfo << '\n';
+    return 1;
+  }
+#elif (LLVM_VERSION_MINOR < 6)
+  std::string ErrorInfo;
+  tool_output_file Out(OutputFilename.c_str(), ErrorInfo, sys::fs::F_None);
+  if (!ErrorInfo.empty()) {
+    errs() << ErrorInfo << '\n';
+    return 1;
+  }
+#else
+  std::error_code EC;
+  tool_output_file Out(OutputFilename, EC, sys::fs::F_None);
+  if (EC) {
+    errs() << EC.message() << '\n';
+    return 1;
+  }
+#endif
+
+  WriteBitcodeToFile(&*M, Out.os());
+  Out.keep();
+
+#if (LLVM_VERSION_MINOR < 6)
+  delete M;
+#endif
+
+  return 0;
+}
@@ -4,9 +4,12 @@
 // License. See LICENSE.TXT for details.
 
 #include <assert.h>
+#include <cstdlib>
 #include <cstring>
+#include <fstream>
 #include <vector>
 #include <set>
+#include <map>
 
 #include "llvm/IR/DataLayout.h"
 #include "llvm/IR/BasicBlock.h"
@@ -14,17 +17,31 @@
 #include "llvm/IR/Function.h"
 #include "llvm/IR/GlobalVariable.h"
 #include "llvm/IR/Instructions.h"
+#include "llvm/IR/IntrinsicInst.h"
 #include "llvm/IR/Module.h"
+#include "llvm/IR/Operator.h"
 #include "llvm/Pass.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/Analysis/ValueTracking.h"
 #include "llvm/IR/Type.h"
 #include "llvm/IR/TypeBuilder.h"
 #if (LLVM_VERSION_MINOR >= 5)
   #include "llvm/IR/InstIterator.h"
+  #include "llvm/IR/DebugInfo.h"
+  #include "llvm/IR/Dominators.h"
+  #include "llvm/IR/CFG.h"
 #else
   #include "llvm/Support/InstIterator.h"
+  #include "llvm/DebugInfo.h"
+  #include "llvm/Analysis/Dominators.h"
+  #include "llvm/Support/CFG.h"
 #endif
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/FileSystem.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Transforms/Utils/BasicBlockUtils.h"
+#include "llvm/Transforms/Utils/Local.h"
 
 using namespace llvm;
 
@@ -50,6 +67,75 @@ static bool array_match(StringRef &name, const char **array)
   return false;
 }
 
+// Every symbolic object that the passes create gets a unique id
+// in its name (e.g. "nondet:12"), so that klee's tests can be mapped
+// back to the source. The sites are recorded in the named metadata,
+// so the ids stay unique over more runs of opt on the module,
+// and nondet-site-table writes them out.
+static const char *nondet_sites_md = "svc15.nondet.sites";
+
+static void get_location(Instruction *I, std::string& file, unsigned& line)
+{
+  // allocas mostly don't have a location, but their dbg.declare has
+  if (AllocaInst *AI = dyn_cast<AllocaInst>(I))
+    if (DbgDeclareInst *DDI = FindAllocaDbgDeclare(AI))
+      I = DDI;
+
+#if (LLVM_VERSION_MINOR < 7)
+  DebugLoc Loc = I->getDebugLoc();
+  if (Loc.isUnknown())
+    return;
+
+  DIScope Scope(Loc.getScope(I->getContext()));
+  file = Scope.getFilename();
+  line = Loc.getLine();
+#else
+  const DebugLoc& Loc = I->getDebugLoc();
+  if (!Loc)
+    return;
+
+  file = Loc->getFilename();
+  line = Loc.getLine();
+#endif
+}
+
+// record new nondet site of the given kind and type at the instruction I
+// and return the name for klee_make_symbolic
+static Constant *get_site_name(Module *M, const char *kind, Instruction *I, Type *Ty)
+{
+  LLVMContext& Ctx = M->getContext();
+  NamedMDNode *sites = M->getOrInsertNamedMetadata(nondet_sites_md);
+  unsigned id = sites->getNumOperands();
+  std::string file = "-";
+  unsigned line = 0;
+
+  get_location(I, file, line);
+
+  // id kind file line function type
+  std::string record;
+  raw_string_ostream rec(record);
+  rec << id << '\t' << kind << '\t' << file << '\t' << line << '\t'
+      << I->getParent()->getParent()->getName() << '\t';
+  Ty->print(rec);
+  rec.flush();
+
+#if (LLVM_VERSION_MINOR < 6)
+  Value *ops[] = { MDString::get(Ctx, record) };
+#else
+  Metadata *ops[] = { MDString::get(Ctx, record) };
+#endif
+  sites->addOperand(MDNode::get(Ctx, ops));
+
+  std::string symname;
+  raw_string_ostream sym(symname);
+  sym << kind << ':' << id;
+  sym.flush();
+
+  Constant *name_init = ConstantDataArray::getString(Ctx, symname);
+  GlobalVariable *name = new GlobalVariable(*M, name_init->getType(), true, GlobalValue::PrivateLinkage, name_init);
+  return ConstantExpr::getPointerCast(name, Type::getInt8PtrTy(Ctx));
+}
+
 bool CheckUnsupported::runOnFunction(Function &F) {
   static const char *unsupported_calls[] = {
     "pthread_create",
@@ -84,16 +170,36 @@ bool CheckUnsupported::runOnFunction(Function &F) {
 namespace {
   class DeleteUndefined : public FunctionPass {
     std::set<const llvm::Value *> removed_calls;
+    // names of undefined functions without side effects
+    // given by the user in -pure-functions file
+    std::set<std::string> pure_functions;
+
+    bool isPure(const Function *callee) const;
 
     public:
       static char ID;
 
       DeleteUndefined() : FunctionPass(ID) {}
 
+      virtual bool doInitialization(Module &M);
       virtual bool runOnFunction(Function &F);
+      virtual void getAnalysisUsage(AnalysisUsage &AU) const;
   };
 }
 
+static cl::opt<std::string> pure_functions_file("pure-functions",
+                                                cl::desc("File with names of undefined functions "
+                                                         "without side effects (one per line)"),
+                                                cl::value_desc("filename"),
+                                                cl::init(""));
+
+// maximal number of earlier calls that the result of a pure call
+// is constrained against
+static cl::opt<unsigned> pure_calls_threshold("pure-calls-threshold",
+                                              cl::desc("maximal number of earlier calls of a pure "
+                                                       "function a result is made consistent with"),
+                                              cl::init(16));
+
 static RegisterPass<DeleteUndefined> DLTU("delete-undefined",
                                           "delete calls to undefined functions");
 char DeleteUndefined::ID;
@@ -124,18 +230,20 @@ static const char *leave_calls[] = {
   "memmove",
   "kzalloc",
   "__errno_location",
+  // modeled in lib/pointer.c, they return only valid objects
+  "__VERIFIER_nondet_pointer",
+  "__VERIFIER_nondet_pchar",
   NULL
 };
 
 // FIXME: don't duplicate the code with -instrument-alloca
 // replace CallInst with alloca with nondeterministic value
 // TODO: what about pointers it takes as parameters?
-static void replaceCall(CallInst *CI, Module *M)
+static LoadInst *replaceCall(CallInst *CI, Module *M)
 {
   LLVMContext& Ctx = M->getContext();
   DataLayout *DL = new DataLayout(M->getDataLayout());
-  Constant *name_init = ConstantDataArray::getString(Ctx, "nondet_from_undef");
-  GlobalVariable *name = new GlobalVariable(*M, name_init->getType(), true, GlobalValue::PrivateLinkage, name_init);
+  Constant *name = get_site_name(M, "nondet_from_undef", CI, CI->getType());
   Type *size_t_Ty;
 
   if (DL->getPointerSizeInBits() > 32)
@@ -168,7 +276,7 @@ static void replaceCall(CallInst *CI, Module *M)
 
   args.push_back(CastI);
   args.push_back(ConstantInt::get(size_t_Ty, DL->getTypeAllocSize(Ty)));
-  args.push_back(ConstantExpr::getPointerCast(name, Type::getInt8PtrTy(Ctx)));
+  args.push_back(name);
   newCI = CallInst::Create(C, args);
 
 
@@ -178,52 +286,320 @@ static void replaceCall(CallInst *CI, Module *M)
   LI->insertAfter(newCI);
 
   CI->replaceAllUsesWith(LI);
+
+  delete DL;
+  return LI;
 }
 
-bool DeleteUndefined::runOnFunction(Function &F)
+// return the called function or NULL if the call is indirect,
+// inline assembly or intrinsic
+static const Function *get_called_function(const CallInst *CI)
 {
-  bool modified = false;
-  Module *M = F.getParent();
+  if (CI->isInlineAsm())
+    return NULL;
 
-  for (inst_iterator I = inst_begin(F), E = inst_end(F); I != E;) {
-    Instruction *ins = &*I;
-    ++I;
-    if (CallInst *CI = dyn_cast<CallInst>(ins)) {
-      if (CI->isInlineAsm())
+  const Function *callee = dyn_cast<Function>(CI->getCalledValue()->stripPointerCasts());
+  if (!callee || callee->isIntrinsic())
+    return NULL;
+
+  return callee;
+}
+
+// is this an undefined function whose calls we replace
+// by nondeterministic values?
+static bool is_removed_undefined(const Function *callee)
+{
+  StringRef name = callee->getName();
+
+  if (name.equals("nondet_int") ||
+      name.equals("klee_int") || array_match(name, leave_calls)) {
+    return false;
+  }
+
+  // if this is __VERIFIER_something call different that to nondet,
+  // keep it
+  if (name.startswith("__VERIFIER") && !name.startswith("__VERIFIER_nondet"))
+    return false;
+
+  return callee->isDeclaration();
+}
+
+bool DeleteUndefined::doInitialization(Module &M)
+{
+  if (pure_functions_file.empty())
+    return false;
+
+  std::ifstream in(pure_functions_file.c_str());
+  if (!in) {
+    errs() << "DeleteUndefined: cannot read '" << pure_functions_file << "'\n";
+    return false;
+  }
+
+  std::string line;
+  while (std::getline(in, line)) {
+    StringRef name = StringRef(line).trim();
+    if (!name.empty() && !name.startswith("#"))
+      pure_functions.insert(name.str());
+  }
+
+  return false;
+}
+
+void DeleteUndefined::getAnalysisUsage(AnalysisUsage &AU) const
+{
+#if (LLVM_VERSION_MINOR < 5)
+  AU.addRequired<DominatorTree>();
+#else
+  AU.addRequired<DominatorTreeWrapperPass>();
+#endif
+}
+
+// calls of a pure function with the same arguments return the same value
+// (readonly functions only until the memory is written, see below)
+bool DeleteUndefined::isPure(const Function *callee) const
+{
+  if (callee->getReturnType()->isVoidTy())
+    return false;
+
+  return callee->doesNotAccessMemory() || callee->onlyReadsMemory() ||
+         pure_functions.count(callee->getName().str());
+}
+
+// an earlier call of a pure undefined function whose result
+// we already replaced (the call itself is erased at the end)
+struct PureCall {
+  CallInst *call;
+  Value *result;
+};
+
+// can we compare A and B by icmp (possibly after a bitcast)?
+// Not for aggregates, vectors and long double. Variadic
+// functions may get arguments of different types
+static bool is_comparable(Value *A, Value *B)
+{
+  Type *Ty = A->getType();
+  if (Ty != B->getType())
+    return false;
+
+  return Ty->isIntegerTy() || Ty->isPointerTy() ||
+         Ty->isFloatTy() || Ty->isDoubleTy();
+}
+
+// the value of V as an integer or pointer, see is_comparable()
+static Value *get_comparable(Value *V, Instruction *InsertBefore)
+{
+  Type *Ty = V->getType();
+  if (Ty->isIntegerTy() || Ty->isPointerTy())
+    return V;
+
+  // compare floats bitwise, so that NaN equals NaN
+  Type *IntTy = IntegerType::get(V->getContext(), Ty->getPrimitiveSizeInBits());
+  return new BitCastInst(V, IntTy, "", InsertBefore);
+}
+
+static Value *compare(CmpInst::Predicate pred, Value *A, Value *B,
+                      Instruction *InsertBefore)
+{
+  assert(is_comparable(A, B));
+  return new ICmpInst(InsertBefore, pred, get_comparable(A, InsertBefore),
+                      get_comparable(B, InsertBefore));
+}
+
+static bool has_same_arguments(const CallInst *A, const CallInst *B)
+{
+  if (A->getNumArgOperands() != B->getNumArgOperands())
+    return false;
+
+  for (unsigned i = 0; i < A->getNumArgOperands(); ++i)
+    if (A->getArgOperand(i) != B->getArgOperand(i))
+      return false;
+
+  return true;
+}
+
+// constrain results of two calls of a pure function by
+// klee_assume(args differ || results equal)
+static bool make_consistent(Module *M, const PureCall &prev, CallInst *CI,
+                            Value *result, Instruction *InsertBefore)
+{
+  // variadic functions may be called with different number of arguments
+  if (prev.call->getNumArgOperands() != CI->getNumArgOperands())
+    return false;
+
+  // check everything before we create any instruction
+  if (!is_comparable(prev.result, result))
+    return false;
+
+  for (unsigned i = 0; i < CI->getNumArgOperands(); ++i) {
+    Value *A = prev.call->getArgOperand(i);
+    Value *B = CI->getArgOperand(i);
+    if (A != B && !is_comparable(A, B))
+      return false;
+  }
+
+  Value *cond = compare(CmpInst::ICMP_EQ, prev.result, result, InsertBefore);
+  for (unsigned i = 0; i < CI->getNumArgOperands(); ++i) {
+    Value *A = prev.call->getArgOperand(i);
+    Value *B = CI->getArgOperand(i);
+    if (A == B)
+      continue;
+
+    Value *differ = compare(CmpInst::ICMP_NE, A, B, InsertBefore);
+    cond = BinaryOperator::CreateOr(cond, differ, "", InsertBefore);
+  }
+
+  LLVMContext& Ctx = M->getContext();
+  DataLayout *DL = new DataLayout(M->getDataLayout());
+  Type *size_t_Ty;
+
+  if (DL->getPointerSizeInBits() > 32)
+    size_t_Ty = Type::getInt64Ty(Ctx);
+  else
+    size_t_Ty = Type::getInt32Ty(Ctx);
+
+  //void klee_assume(uintptr_t condition);
+  Constant *assume = M->getOrInsertFunction("klee_assume",
+                                            Type::getVoidTy(Ctx),
+                                            size_t_Ty, // condition
+                                            NULL);
+
+  Value *ext = new ZExtInst(cond, size_t_Ty, "", InsertBefore);
+  CallInst::Create(assume, ext, "", InsertBefore);
+
+  delete DL;
+  return true;
+}
+
+// may the memory change between the two calls in the same block?
+// Our own instrumentation and the calls we remove do not count.
+static bool is_memory_written_between(CallInst *from, CallInst *to,
+                                      const std::set<CallInst *> &removed)
+{
+  BasicBlock::iterator I(from);
+  for (++I; &*I != to; ++I) {
+    if (!I->mayWriteToMemory())
+      continue;
+
+    if (CallInst *CI = dyn_cast<CallInst>(&*I)) {
+      if (removed.count(CI))
         continue;
 
-      const Value *val = CI->getCalledValue()->stripPointerCasts();
-      const Function *callee = dyn_cast<Function>(val);
-      if (!callee || callee->isIntrinsic())
+      const Function *callee = get_called_function(CI);
+      if (callee && (callee->getName().equals("klee_make_symbolic") ||
+                     callee->getName().equals("klee_assume")))
+        continue;
+    }
+
+    return true;
+  }
+
+  return false;
+}
+
+bool DeleteUndefined::runOnFunction(Function &F)
+{
+  Module *M = F.getParent();
+#if (LLVM_VERSION_MINOR < 5)
+  DominatorTree &DT = getAnalysis<DominatorTree>();
+#else
+  DominatorTree &DT = getAnalysis<DominatorTreeWrapperPass>().getDomTree();
+#endif
+
+  std::vector<CallInst *> calls;
+  for (inst_iterator I = inst_begin(F), E = inst_end(F); I != E; ++I) {
+    if (CallInst *CI = dyn_cast<CallInst>(&*I)) {
+      const Function *callee = get_called_function(CI);
+      if (!callee)
         continue;
 
       assert(callee->hasName());
-      StringRef name = callee->getName();
+      if (is_removed_undefined(callee))
+        calls.push_back(CI);
+    }
+  }
+
+  if (calls.empty())
+    return false;
+
+  // the calls stay in the code until the end, so that we can
+  // still compare their arguments with the arguments of later calls
+  std::set<CallInst *> removed(calls.begin(), calls.end());
+  std::map<const Function *, std::vector<PureCall> > pure_calls;
+  unsigned shared = 0, constrained = 0;
+
+  for (std::vector<CallInst *>::iterator I = calls.begin(), E = calls.end();
+       I != E; ++I) {
+    CallInst *CI = *I;
+    const Function *callee = get_called_function(CI);
+    StringRef name = callee->getName();
+
+    if (removed_calls.insert(callee).second)
+      // print only once
+      errs() << "Prepare: removing calls to '" << name << "' (function is undefined)\n";
+
+    if (CI->getType()->isVoidTy())
+      continue;
 
-      if (name.equals("nondet_int") ||
-          name.equals("klee_int") || array_match(name, leave_calls)) {
+    if (!isPure(callee)) {
+      replaceCall(CI, M);
+      continue;
+    }
+
+    // calls of a readonly function see the same memory only
+    // if nothing is written in between
+    bool needs_same_memory = !callee->doesNotAccessMemory() &&
+                             !pure_functions.count(name.str());
+
+    std::vector<PureCall> &prev_calls = pure_calls[callee];
+    std::vector<PureCall> dominating;
+    Value *result = NULL;
+
+    for (std::vector<PureCall>::reverse_iterator P = prev_calls.rbegin(),
+         PE = prev_calls.rend(); P != PE; ++P) {
+      if (!DT.dominates(P->call, CI))
         continue;
-      }
 
-      // if this is __VERIFIER_something call different that to nondet,
-      // keep it
-      if (name.startswith("__VERIFIER") && !name.startswith("__VERIFIER_nondet"))
+      if (needs_same_memory &&
+          (P->call->getParent() != CI->getParent() ||
+           is_memory_written_between(P->call, CI, removed)))
         continue;
 
-      if (callee->isDeclaration()) {
-        if (removed_calls.insert(callee).second)
-          // print only once
-          errs() << "Prepare: removing calls to '" << name << "' (function is undefined)\n";
+      if (has_same_arguments(P->call, CI)) {
+        result = P->result;
+        break;
+      }
 
-        if (!CI->getType()->isVoidTy())
-          replaceCall(CI, M);
+      if (dominating.size() < pure_calls_threshold)
+        dominating.push_back(*P);
+    }
 
-        CI->eraseFromParent();
-        modified = true;
-      }
+    if (result) {
+      CI->replaceAllUsesWith(result);
+      ++shared;
+      continue;
     }
+
+    LoadInst *LI = replaceCall(CI, M);
+    Instruction *InsertBefore = &*++BasicBlock::iterator(LI);
+    for (std::vector<PureCall>::iterator P = dominating.begin(),
+         PE = dominating.end(); P != PE; ++P)
+      if (make_consistent(M, *P, CI, LI, InsertBefore))
+        ++constrained;
+
+    PureCall PC = { CI, LI };
+    prev_calls.push_back(PC);
   }
-  return modified;
+
+  for (std::vector<CallInst *>::iterator I = calls.begin(), E = calls.end();
+       I != E; ++I)
+    (*I)->eraseFromParent();
+
+  if (shared || constrained)
+    errs() << "DeleteUndefined: " << F.getName() << ": " << shared
+           << " pure calls share a result, " << constrained
+           << " pairs of results constrained\n";
+
+  return true;
 }
 
 namespace {
@@ -244,10 +620,16 @@ static RegisterPass<Prepare> PRP("prepare",
                                  "Prepare the code for svcomp");
 char Prepare::ID;
 
+// the entry of the verified program
+static Function *find_main(Module &M)
+{
+  return M.getFunction("main");
+}
+
 void Prepare::findInitFuns(Module &M) {
   SmallVector<Constant *, 1> initFns;
   Type *ETy = TypeBuilder<void *, false>::get(M.getContext());
-  Function *_main = M.getFunction("main");
+  Function *_main = find_main(M);
   assert(_main);
 
   initFns.push_back(ConstantExpr::getBitCast(_main, ETy));
@@ -262,8 +644,6 @@ bool Prepare::runOnModule(Module &M) {
     "kzalloc",
     "nondet_int",
     "__VERIFIER_assume",
-    "__VERIFIER_nondet_pointer",
-    "__VERIFIER_nondet_pchar",
     "__VERIFIER_nondet_char",
     "__VERIFIER_nondet_short",
     "__VERIFIER_nondet_int",
@@ -331,38 +711,247 @@ static RegisterPass<InstrumentAllocNeverFails> INSTALLOCNF("instrument-alloc-nf"
                                                            "allocation never fail");
 char InstrumentAllocNeverFails::ID;
 
-static void replace_malloc(Module *M, CallInst *CI, bool never_fails)
+static bool is_same_size(Value *A, Value *B)
 {
-  Constant *C = NULL;
+  if (A == B)
+    return true;
 
-  if (never_fails)
-    C = M->getOrInsertFunction("__VERIFIER_malloc0", CI->getType(), CI->getOperand(0)->getType(), NULL);
-  else
-    C = M->getOrInsertFunction("__VERIFIER_malloc", CI->getType(), CI->getOperand(0)->getType(), NULL);
+  ConstantInt *CA = dyn_cast<ConstantInt>(A);
+  ConstantInt *CB = dyn_cast<ConstantInt>(B);
+  return CA && CB && CA->getZExtValue() == CB->getZExtValue();
+}
+
+// is the alloca only loaded and stored to, so that nothing
+// can get at the value stored in it other than by a load?
+static bool is_local_slot(Value *V)
+{
+  AllocaInst *AI = dyn_cast<AllocaInst>(V);
+  if (!AI)
+    return false;
+
+#if (LLVM_VERSION_MINOR < 5)
+  for (Value::use_iterator U = AI->use_begin(), E = AI->use_end(); U != E; ++U) {
+#else
+  for (Value::user_iterator U = AI->user_begin(), E = AI->user_end(); U != E; ++U) {
+#endif
+    if (isa<LoadInst>(*U))
+      continue;
+
+    StoreInst *SI = dyn_cast<StoreInst>(*U);
+    if (!SI || SI->getValueOperand() == AI)
+      return false;
+  }
+
+  return true;
+}
+
+// Check whether the memory returned by malloc is completely overwritten
+// (by memset, memcpy or a store of its size) before it can be read.
+// Until the pointer is used, nothing can read the memory, so we just
+// follow the code after the call (on NULL check the not-NULL branch)
+// and look at the first use of the pointer that is not a cast or comparison.
+// Without optimizations the pointer is kept in a local variable,
+// so we follow it through the variable too (slots)
+static bool is_overwritten_before_read(CallInst *CI, DataLayout *DL)
+{
+  Value *size = CI->getArgOperand(0);
+  std::set<Value *> ptrs;
+  std::set<Value *> slots;
+  BasicBlock *B = CI->getParent();
+  BasicBlock::iterator I = BasicBlock::iterator(CI);
+  std::set<BasicBlock *> visited;
+
+  ptrs.insert(CI);
+  visited.insert(B);
+  ++I;
+
+  while (true) {
+    for (BasicBlock::iterator E = B->end(); I != E; ++I) {
+      Instruction *ins = &*I;
+      bool uses_ptr = false;
+
+      if (LoadInst *LI = dyn_cast<LoadInst>(ins)) {
+        if (slots.count(LI->getPointerOperand())) {
+          ptrs.insert(LI);
+          continue;
+        }
+      }
+
+      if (StoreInst *SI = dyn_cast<StoreInst>(ins)) {
+        if (ptrs.count(SI->getValueOperand())) {
+          if (!is_local_slot(SI->getPointerOperand()))
+            return false;
+
+          slots.insert(SI->getPointerOperand());
+          continue;
+        }
+
+        // the variable does not hold the pointer anymore
+        slots.erase(SI->getPointerOperand());
+      }
+
+      for (User::op_iterator O = ins->op_begin(), OE = ins->op_end(); O != OE; ++O)
+        if (ptrs.count(*O))
+          uses_ptr = true;
+
+      if (!uses_ptr)
+        continue;
+
+      if (isa<BitCastInst>(ins)) {
+        ptrs.insert(ins);
+        continue;
+      }
+
+      // comparing the pointer (mostly with NULL) does not read the memory
+      if (isa<ICmpInst>(ins))
+        continue;
+
+      if (MemSetInst *MS = dyn_cast<MemSetInst>(ins))
+        return ptrs.count(MS->getDest()) && is_same_size(MS->getLength(), size);
+
+      if (MemTransferInst *MT = dyn_cast<MemTransferInst>(ins))
+        return ptrs.count(MT->getDest()) && !ptrs.count(MT->getSource())
+               && is_same_size(MT->getLength(), size);
+
+      if (StoreInst *SI = dyn_cast<StoreInst>(ins)) {
+        ConstantInt *CSize = dyn_cast<ConstantInt>(size);
+        return CSize && DL->getTypeStoreSize(SI->getValueOperand()->getType())
+                        >= CSize->getZExtValue();
+      }
+
+      // anything else may read the memory or let the pointer escape
+      return false;
+    }
+
+    // continue to the next block if the way is unique
+    BranchInst *BI = dyn_cast<BranchInst>(B->getTerminator());
+    if (!BI)
+      return false;
+
+    BasicBlock *next = NULL;
+    if (BI->isUnconditional())
+      next = BI->getSuccessor(0);
+    else if (ICmpInst *Cmp = dyn_cast<ICmpInst>(BI->getCondition())) {
+      // if (ptr == NULL) - on the NULL branch there is no memory to read
+      bool null_check = (ptrs.count(Cmp->getOperand(0)) && isa<ConstantPointerNull>(Cmp->getOperand(1)))
+                        || (ptrs.count(Cmp->getOperand(1)) && isa<ConstantPointerNull>(Cmp->getOperand(0)));
+      if (!null_check)
+        return false;
+
+      if (Cmp->getPredicate() == CmpInst::ICMP_EQ)
+        next = BI->getSuccessor(1);
+      else if (Cmp->getPredicate() == CmpInst::ICMP_NE)
+        next = BI->getSuccessor(0);
+    }
+
+    if (!next || next->getSinglePredecessor() != B
+        || !visited.insert(next).second)
+      return false;
+
+    B = next;
+    I = B->begin();
+  }
+}
 
+// the type of the allocated object, if the program tells us
+static Type *get_allocated_type(CallInst *CI)
+{
+#if (LLVM_VERSION_MINOR < 5)
+  for (Value::use_iterator U = CI->use_begin(), E = CI->use_end(); U != E; ++U)
+#else
+  for (Value::user_iterator U = CI->user_begin(), E = CI->user_end(); U != E; ++U)
+#endif
+    if (BitCastInst *BC = dyn_cast<BitCastInst>(*U))
+      return BC->getDestTy()->getPointerElementType();
+
+  return CI->getType()->getPointerElementType();
+}
+
+// replace the allocation by a call of our model, it gets
+// the name of the site as the last argument
+static void replace_alloc(Module *M, CallInst *CI, const char *fun, const char *kind)
+{
+  LLVMContext& Ctx = M->getContext();
+  std::vector<Type *> arg_types;
+  std::vector<Value *> args;
+
+  for (unsigned i = 0; i < CI->getNumArgOperands(); ++i) {
+    args.push_back(CI->getArgOperand(i));
+    arg_types.push_back(CI->getArgOperand(i)->getType());
+  }
+
+  args.push_back(get_site_name(M, kind, CI, get_allocated_type(CI)));
+  arg_types.push_back(Type::getInt8PtrTy(Ctx));
+
+  Constant *C = M->getOrInsertFunction(fun, FunctionType::get(CI->getType(), arg_types, false));
   assert(C);
-  Function *Malloc = cast<Function>(C);
 
-  CI->setCalledFunction(Malloc);
+  CallInst *newCI = CallInst::Create(C, args, "", CI);
+  newCI->takeName(CI);
+  newCI->setDebugLoc(CI->getDebugLoc());
+  CI->replaceAllUsesWith(newCI);
+  CI->eraseFromParent();
+}
+
+static void replace_malloc(Module *M, CallInst *CI, bool never_fails, bool concrete)
+{
+  const char *name;
+
+  // memory that is overwritten before it is read does not need to be symbolic
+  if (never_fails)
+    name = concrete ? "__VERIFIER_malloc0_concrete" : "__VERIFIER_malloc0";
+  else
+    name = concrete ? "__VERIFIER_malloc_concrete" : "__VERIFIER_malloc";
+
+  replace_alloc(M, CI, name, never_fails ? "malloc0" : "malloc");
 }
 
+// calloc'd memory is zeroed by klee without creating any symbolic array.
+// With this option the memory is made symbolic and then zeroed instead,
+// so that the slicer may remove the zeroing when it is overwritten anyway
+static cl::opt<bool> symbolic_calloc("symbolic-calloc",
+                                     cl::desc("make calloc'd memory symbolic and then zero it"),
+                                     cl::init(false));
+
 static void replace_calloc(Module *M, CallInst *CI, bool never_fails)
 {
-  Constant *C = NULL;
+  const char *name;
+
   if (never_fails)
-    C = M->getOrInsertFunction("__VERIFIER_calloc0", CI->getType(), CI->getOperand(0)->getType(), CI->getOperand(1)->getType(), NULL);
+    name = symbolic_calloc ? "__VERIFIER_calloc0_symbolic" : "__VERIFIER_calloc0";
   else
-    C = M->getOrInsertFunction("__VERIFIER_calloc", CI->getType(), CI->getOperand(0)->getType(), CI->getOperand(1)->getType(), NULL);
+    name = symbolic_calloc ? "__VERIFIER_calloc_symbolic" : "__VERIFIER_calloc";
+
+  replace_alloc(M, CI, name, never_fails ? "calloc0" : "calloc");
+}
 
+// call our model of free or realloc instead, it keeps
+// the registry of objects for __VERIFIER_nondet_pointer
+static void replace_free(Module *M, CallInst *CI, const char *fun)
+{
+  std::vector<Type *> arg_types;
+  std::vector<Value *> args;
+
+  for (unsigned i = 0; i < CI->getNumArgOperands(); ++i) {
+    args.push_back(CI->getArgOperand(i));
+    arg_types.push_back(CI->getArgOperand(i)->getType());
+  }
+
+  Constant *C = M->getOrInsertFunction(fun, FunctionType::get(CI->getType(), arg_types, false));
   assert(C);
-  Function *Calloc = cast<Function>(C);
-  CI->setCalledFunction(Calloc);
+
+  CallInst *newCI = CallInst::Create(C, args, "", CI);
+  newCI->takeName(CI);
+  newCI->setDebugLoc(CI->getDebugLoc());
+  CI->replaceAllUsesWith(newCI);
+  CI->eraseFromParent();
 }
 
 static bool instrument_alloc(Function &F, bool never_fails)
 {
   bool modified = false;
   Module *M = F.getParent();
+  DataLayout *DL = new DataLayout(M->getDataLayout());
 
   for (inst_iterator I = inst_begin(F), E = inst_end(F); I != E;) {
     Instruction *ins = &*I;
@@ -380,14 +969,22 @@ static bool instrument_alloc(Function &F, bool never_fails)
       StringRef name = callee->getName();
 
       if (name.equals("malloc")) {
-        replace_malloc(M, CI, never_fails);
+        replace_malloc(M, CI, never_fails, is_overwritten_before_read(CI, DL));
         modified = true;
       } else if (name.equals("calloc")) {
         replace_calloc(M, CI, never_fails);
         modified = true;
+      } else if (name.equals("free")) {
+        replace_free(M, CI, "__VERIFIER_free");
+        modified = true;
+      } else if (name.equals("realloc")) {
+        replace_free(M, CI, "__VERIFIER_realloc");
+        modified = true;
       }
     }
   }
+
+  delete DL;
   return modified;
 }
 
@@ -401,6 +998,109 @@ bool InstrumentAllocNeverFails::runOnFunction(Function &F)
     return instrument_alloc(F, true /* never fails */);
 }
 
+// aggregates up to this size are initialized by storing a symbolic value,
+// larger ones are made symbolic in place
+static cl::opt<unsigned> uninit_store_threshold("uninit-store-threshold",
+                                                cl::desc("maximal size (in bytes) of aggregate "
+                                                         "initialized by a store of symbolic value"),
+                                                cl::init(16));
+
+static bool has_padding(Type *Ty, DataLayout *DL)
+{
+  if (StructType *STy = dyn_cast<StructType>(Ty)) {
+    uint64_t size = 0;
+    for (unsigned i = 0; i < STy->getNumElements(); ++i) {
+      Type *ETy = STy->getElementType(i);
+      if (has_padding(ETy, DL))
+        return true;
+      size += DL->getTypeAllocSize(ETy);
+    }
+
+    return size != DL->getStructLayout(STy)->getSizeInBytes();
+  }
+
+  if (ArrayType *ATy = dyn_cast<ArrayType>(Ty))
+    return has_padding(ATy->getElementType(), DL);
+
+  return DL->getTypeStoreSize(Ty) != DL->getTypeAllocSize(Ty);
+}
+
+// call klee_make_symbolic on the memory of type Ty at Ptr
+// field by field, so that the padding stays concrete
+static void make_symbolic_in_place(Constant *MakeSymbolic, Value *Ptr, Type *Ty,
+                                   Constant *name, Type *size_t_Ty, DataLayout *DL,
+                                   Instruction *InsertBefore)
+{
+  LLVMContext& Ctx = Ty->getContext();
+  StructType *STy = dyn_cast<StructType>(Ty);
+
+  if (STy && has_padding(STy, DL)) {
+    for (unsigned i = 0; i < STy->getNumElements(); ++i) {
+      Value *idx[] = {
+        ConstantInt::get(Type::getInt32Ty(Ctx), 0),
+        ConstantInt::get(Type::getInt32Ty(Ctx), i)
+      };
+      GetElementPtrInst *GEP = GetElementPtrInst::Create(Ptr, idx, "", InsertBefore);
+      make_symbolic_in_place(MakeSymbolic, GEP, STy->getElementType(i),
+                             name, size_t_Ty, DL, InsertBefore);
+    }
+    return;
+  }
+
+  // scalars with padding (e.g. x86_fp80) have the value in the first bytes,
+  // arrays of padded structures are made symbolic whole
+  uint64_t size = Ty->isArrayTy() ? DL->getTypeAllocSize(Ty) : DL->getTypeStoreSize(Ty);
+  if (size == 0)
+    return;
+
+  std::vector<Value *> args;
+  args.push_back(CastInst::CreatePointerCast(Ptr, Type::getInt8PtrTy(Ctx), "", InsertBefore));
+  args.push_back(ConstantInt::get(size_t_Ty, size));
+  args.push_back(name);
+  CallInst::Create(MakeSymbolic, args, "", InsertBefore);
+}
+
+// Make all the small locals that are initialized by a store
+// from one symbolic frame, so that there is one klee_make_symbolic call
+// and one symbolic array per activation of the function
+static cl::opt<bool> uninit_batch_frame("uninit-batch-frame",
+                                        cl::desc("initialize the scalar locals of a function "
+                                                 "from one symbolic frame"),
+                                        cl::init(false));
+
+// create the symbolic frame with the types of the given allocas
+// and initialize each alloca from its slice of the frame
+static void initialize_from_frame(Module *M, Constant *MakeSymbolic,
+                                  std::vector<AllocaInst *>& locals,
+                                  Type *size_t_Ty, DataLayout *DL,
+                                  Instruction *InsertBefore)
+{
+  LLVMContext& Ctx = M->getContext();
+  std::vector<Type *> types;
+
+  for (std::vector<AllocaInst *>::iterator I = locals.begin(), E = locals.end(); I != E; ++I)
+    types.push_back((*I)->getAllocatedType());
+
+  StructType *FrameTy = StructType::get(Ctx, types);
+  AllocaInst *Frame = new AllocaInst(FrameTy, "nondet_frame", InsertBefore);
+
+  std::vector<Value *> args;
+  args.push_back(CastInst::CreatePointerCast(Frame, Type::getInt8PtrTy(Ctx), "", InsertBefore));
+  args.push_back(ConstantInt::get(size_t_Ty, DL->getTypeAllocSize(FrameTy)));
+  args.push_back(get_site_name(M, "nondet_frame", locals[0], FrameTy));
+  CallInst::Create(MakeSymbolic, args, "", InsertBefore);
+
+  for (unsigned i = 0; i < locals.size(); ++i) {
+    Value *idx[] = {
+      ConstantInt::get(Type::getInt32Ty(Ctx), 0),
+      ConstantInt::get(Type::getInt32Ty(Ctx), i)
+    };
+    GetElementPtrInst *GEP = GetElementPtrInst::Create(Frame, idx, "", InsertBefore);
+    LoadInst *LI = new LoadInst(GEP, "", InsertBefore);
+    new StoreInst(LI, locals[i], InsertBefore);
+  }
+}
+
 class InitializeUninitialized : public FunctionPass {
   public:
     static char ID;
@@ -421,8 +1121,6 @@ bool InitializeUninitialized::runOnFunction(Function &F)
   Module *M = F.getParent();
   LLVMContext& Ctx = M->getContext();
   DataLayout *DL = new DataLayout(M->getDataLayout());
-  Constant *name_init = ConstantDataArray::getString(Ctx, "nondet");
-  GlobalVariable *name = new GlobalVariable(*M, name_init->getType(), true, GlobalValue::PrivateLinkage, name_init);
   Type *size_t_Ty;
 
   if (DL->getPointerSizeInBits() > 32)
@@ -438,8 +1136,24 @@ bool InitializeUninitialized::runOnFunction(Function &F)
                                        Type::getInt8PtrTy(Ctx), // name
                                        NULL);
 
+  // the static allocas at the beginning of the entry block can be
+  // initialized together before anything else in the function happens
+  std::set<AllocaInst *> batchable;
+  std::vector<AllocaInst *> batched;
+  Instruction *FrameInsertPt = NULL;
+
+  if (uninit_batch_frame) {
+    BasicBlock::iterator I = F.getEntryBlock().begin();
+    while (AllocaInst *AI = dyn_cast<AllocaInst>(&*I)) {
+      if (AI->isStaticAlloca())
+        batchable.insert(AI);
+      ++I;
+    }
 
-  for (inst_iterator I = inst_begin(F), E = inst_end(F); I != E;) {
+    FrameInsertPt = &*I;
+  }
+
+  for (inst_iterator I = inst_begin(F), E = inst_end(F); I != E;) {
     Instruction *ins = &*I;
     ++I;
 
@@ -457,17 +1171,34 @@ bool InitializeUninitialized::runOnFunction(Function &F)
       // to the original alloca. This way slicer will slice this
       // initialization away if program initialize it manually later
       if (Ty->isSized()) {
+        bool store_based = !Ty->isArrayTy() &&
+                           !(Ty->isAggregateType() &&
+                             DL->getTypeAllocSize(Ty) > uninit_store_threshold);
+        if (store_based && batchable.count(AI)) {
+          batched.push_back(AI);
+          continue;
+        }
+
+        Constant *name = get_site_name(M, "nondet", AI, Ty);
+
         // if this is an array allocation, just call klee_make_symbolic on it,
         // since storing whole symbolic array into it would have soo huge overhead
         if (Ty->isArrayTy()) {
             CastI = CastInst::CreatePointerCast(AI, Type::getInt8PtrTy(Ctx));
             args.push_back(CastI);
             args.push_back(ConstantInt::get(size_t_Ty, DL->getTypeAllocSize(Ty)));
-            args.push_back(ConstantExpr::getPointerCast(name, Type::getInt8PtrTy(Ctx)));
+            args.push_back(name);
 
             CI = CallInst::Create(C, args);
             CastI->insertAfter(AI);
             CI->insertAfter(CastI);
+        } else if (Ty->isAggregateType() &&
+                   DL->getTypeAllocSize(Ty) > uninit_store_threshold) {
+            // storing a large symbolic aggregate would double the memory
+            // and create huge expressions, so make it symbolic in place
+            // (without the padding)
+            make_symbolic_in_place(C, AI, Ty, name, size_t_Ty, DL,
+                                   &*++BasicBlock::iterator(AI));
         } else {
             // when this is not an array allocation, create new symbolic memory and
             // store it into the allocated memory using normal StoreInst.
@@ -477,7 +1208,7 @@ bool InitializeUninitialized::runOnFunction(Function &F)
 
             args.push_back(CastI);
             args.push_back(ConstantInt::get(size_t_Ty, DL->getTypeAllocSize(Ty)));
-            args.push_back(ConstantExpr::getPointerCast(name, Type::getInt8PtrTy(Ctx)));
+            args.push_back(name);
             CI = CallInst::Create(C, args);
 
             LI = new LoadInst(newAlloca);
@@ -495,6 +1226,1711 @@ bool InitializeUninitialized::runOnFunction(Function &F)
     }
   }
 
+  if (!batched.empty()) {
+    initialize_from_frame(M, C, batched, size_t_Ty, DL, FrameInsertPt);
+    modified = true;
+  }
+
+  delete DL;
+  return modified;
+}
+
+// cost threshold for IfToSelect, in number of speculated instructions
+static cl::opt<unsigned> if_to_select_threshold("if-to-select-threshold",
+                                                cl::desc("maximal number of instructions executed "
+                                                         "speculatively in one branch"),
+                                                cl::init(4));
+
+// Every branch on a symbolic value makes klee fork. Small if-then(-else)
+// blocks without side effects (min/max, clamps, flags) can be executed
+// unconditionally and the result chosen by select instead.
+// The only side effects we allow are stores to local variables, the
+// value to store is chosen by select as well and stored after the branch
+// (like SimplifyCFG does), so that the pass works also on the code
+// before mem2reg where every assignment is a store to an alloca.
+class IfToSelect : public FunctionPass {
+  unsigned converted_branches;
+
+  public:
+    static char ID;
+
+    IfToSelect() : FunctionPass(ID), converted_branches(0) {}
+
+    virtual bool runOnFunction(Function &F);
+    virtual bool doFinalization(Module &M);
+};
+
+static RegisterPass<IfToSelect> IFTOSEL("if-to-select",
+                                        "convert small side-effect free branches into selects");
+char IfToSelect::ID;
+
+// return the target of unconditional branch that terminates the block
+static BasicBlock *get_unique_succ(BasicBlock *B)
+{
+  BranchInst *BI = dyn_cast<BranchInst>(B->getTerminator());
+  if (!BI || BI->isConditional())
+    return NULL;
+
+  return BI->getSuccessor(0);
+}
+
+// a store to a local variable that we can turn into a select
+static AllocaInst *get_speculated_store(Instruction *I)
+{
+  StoreInst *SI = dyn_cast<StoreInst>(I);
+  if (!SI || !SI->isSimple())
+    return NULL;
+
+  return dyn_cast<AllocaInst>(SI->getPointerOperand());
+}
+
+// can we execute the block B everytime we execute Pred?
+static bool can_speculate_block(BasicBlock *B, BasicBlock *Pred)
+{
+  std::set<Value *> stored;
+  unsigned cost = 0;
+
+  if (B->getSinglePredecessor() != Pred)
+    return false;
+
+  for (BasicBlock::iterator I = B->begin(), E = B->end(); I != E; ++I) {
+    Instruction *ins = &*I;
+    if (ins == B->getTerminator())
+      break;
+
+    if (isa<DbgInfoIntrinsic>(ins))
+      continue;
+
+    if (isa<PHINode>(ins))
+      return false;
+
+    // no calls except for the intrinsics without side effects
+    // (e.g. klee_make_symbolic must stay where it is)
+    if (isa<CallInst>(ins) && !isa<IntrinsicInst>(ins))
+      return false;
+
+    if (AllocaInst *AI = get_speculated_store(ins)) {
+      stored.insert(AI);
+      if (++cost > if_to_select_threshold)
+        return false;
+      continue;
+    }
+
+    // the stores are done after the branch, so the stored value
+    // can be forwarded only to the loads of the whole variable
+    if (LoadInst *LI = dyn_cast<LoadInst>(ins)) {
+      Value *Ptr = LI->getPointerOperand();
+      if (Ptr != Ptr->stripInBoundsOffsets() && stored.count(Ptr->stripInBoundsOffsets()))
+        return false;
+    }
+
+    // no other stores, no loads from memory that may be invalid,
+    // no division that may trap etc.
+    if (!isSafeToSpeculativelyExecute(ins))
+      return false;
+
+    if (++cost > if_to_select_threshold)
+      return false;
+  }
+
+  return true;
+}
+
+// remove the stores to local variables from the block and forward
+// the stored values to the loads, the values are stored in `stored'
+static void remove_stores(BasicBlock *B, std::map<AllocaInst *, Value *>& stored)
+{
+  for (BasicBlock::iterator I = B->begin(), E = B->end(); I != E;) {
+    Instruction *ins = &*I;
+    ++I;
+
+    if (AllocaInst *AI = get_speculated_store(ins)) {
+      stored[AI] = cast<StoreInst>(ins)->getValueOperand();
+      ins->eraseFromParent();
+    } else if (LoadInst *LI = dyn_cast<LoadInst>(ins)) {
+      AllocaInst *AI = dyn_cast<AllocaInst>(LI->getPointerOperand());
+      if (AI && stored.count(AI) && stored[AI]->getType() == LI->getType()) {
+        LI->replaceAllUsesWith(stored[AI]);
+        LI->eraseFromParent();
+      }
+    }
+  }
+}
+
+static bool convert_branch(BasicBlock *BB)
+{
+  BranchInst *BI = dyn_cast<BranchInst>(BB->getTerminator());
+  if (!BI || !BI->isConditional())
+    return false;
+
+  BasicBlock *S0 = BI->getSuccessor(0);
+  BasicBlock *S1 = BI->getSuccessor(1);
+  if (S0 == S1 || S0 == BB || S1 == BB)
+    return false;
+
+  // blocks that will be speculated (may be NULL in triangles)
+  BasicBlock *TrueBB = NULL, *FalseBB = NULL;
+  BasicBlock *Join = NULL;
+  BasicBlock *succ0 = get_unique_succ(S0);
+  BasicBlock *succ1 = get_unique_succ(S1);
+
+  if (succ0 && succ0 == succ1) {
+    // if (c) { S0 } else { S1 }
+    TrueBB = S0;
+    FalseBB = S1;
+    Join = succ0;
+  } else if (succ0 == S1) {
+    // if (c) { S0 }
+    TrueBB = S0;
+    Join = S1;
+  } else if (succ1 == S0) {
+    // if (!c) { S1 }
+    FalseBB = S1;
+    Join = S0;
+  } else
+    return false;
+
+  if (Join == BB)
+    return false;
+
+  if (TrueBB && !can_speculate_block(TrueBB, BB))
+    return false;
+  if (FalseBB && !can_speculate_block(FalseBB, BB))
+    return false;
+
+  BasicBlock *TrueIn = TrueBB ? TrueBB : BB;
+  BasicBlock *FalseIn = FalseBB ? FalseBB : BB;
+
+  std::map<AllocaInst *, Value *> true_stores, false_stores;
+  if (TrueBB)
+    remove_stores(TrueBB, true_stores);
+  if (FalseBB)
+    remove_stores(FalseBB, false_stores);
+
+  // move the instructions in front of the branch
+  if (TrueBB)
+    BB->getInstList().splice(BasicBlock::iterator(BI), TrueBB->getInstList(),
+                             TrueBB->begin(), BasicBlock::iterator(TrueBB->getTerminator()));
+  if (FalseBB)
+    BB->getInstList().splice(BasicBlock::iterator(BI), FalseBB->getInstList(),
+                             FalseBB->begin(), BasicBlock::iterator(FalseBB->getTerminator()));
+
+  // store the chosen values, the memory did not change
+  // in the meantime, so the old values can be loaded here
+  std::set<AllocaInst *> allocas;
+  for (std::map<AllocaInst *, Value *>::iterator I = true_stores.begin(),
+       E = true_stores.end(); I != E; ++I)
+    allocas.insert(I->first);
+  for (std::map<AllocaInst *, Value *>::iterator I = false_stores.begin(),
+       E = false_stores.end(); I != E; ++I)
+    allocas.insert(I->first);
+
+  for (std::set<AllocaInst *>::iterator I = allocas.begin(), E = allocas.end();
+       I != E; ++I) {
+    AllocaInst *AI = *I;
+    Value *TV = true_stores.count(AI) ? true_stores[AI] : NULL;
+    Value *FV = false_stores.count(AI) ? false_stores[AI] : NULL;
+
+    if (!TV || !FV) {
+      LoadInst *Old = new LoadInst(AI, AI->getName() + ".old", BI);
+      if (!TV)
+        TV = Old;
+      else
+        FV = Old;
+    }
+
+    Value *V = TV;
+    if (TV != FV)
+      V = SelectInst::Create(BI->getCondition(), TV, FV, AI->getName() + ".sel", BI);
+    new StoreInst(V, AI, BI);
+  }
+
+  // and choose the values that flow into the join block
+  for (BasicBlock::iterator I = Join->begin(); PHINode *PN = dyn_cast<PHINode>(I); ++I) {
+    Value *TV = PN->getIncomingValueForBlock(TrueIn);
+    Value *FV = PN->getIncomingValueForBlock(FalseIn);
+    Value *V = TV;
+
+    if (TV != FV)
+      V = SelectInst::Create(BI->getCondition(), TV, FV, PN->getName() + ".sel", BI);
+
+    if (TrueBB)
+      PN->removeIncomingValue(TrueBB, false /* delete if empty */);
+    if (FalseBB)
+      PN->removeIncomingValue(FalseBB, false /* delete if empty */);
+
+    if (TrueBB && FalseBB)
+      PN->addIncoming(V, BB);
+    else
+      PN->setIncomingValue(PN->getBasicBlockIndex(BB), V);
+  }
+
+  BranchInst::Create(Join, BI);
+  BI->eraseFromParent();
+
+  if (TrueBB)
+    TrueBB->eraseFromParent();
+  if (FalseBB)
+    FalseBB->eraseFromParent();
+
+  return true;
+}
+
+bool IfToSelect::runOnFunction(Function &F)
+{
+  bool modified = false;
+  bool changed;
+
+  // converting inner branches can make the outer ones convertible
+  do {
+    changed = false;
+    for (Function::iterator I = F.begin(), E = F.end(); I != E;) {
+      BasicBlock *BB = &*I;
+      if (convert_branch(BB)) {
+        ++converted_branches;
+        changed = true;
+        // the next block may have been erased, try this one again
+        continue;
+      }
+
+      ++I;
+    }
+
+    modified |= changed;
+  } while (changed);
+
+  return modified;
+}
+
+bool IfToSelect::doFinalization(Module &M)
+{
+  (void) M;
+  errs() << "IfToSelect: converted " << converted_branches << " branches\n";
+  return false;
+}
+
+static cl::opt<std::string> cost_output("cost-output",
+                                        cl::desc("File for the cost vector of estimate-cost "
+                                                 "(default: standard output)"),
+                                        cl::value_desc("filename"),
+                                        cl::init("-"));
+
+// write data to the file, "-" is the standard output
+static bool write_output(const std::string& filename, const std::string& data)
+{
+  if (filename == "-") {
+    outs() << data;
+    return true;
+  }
+
+#if (LLVM_VERSION_MINOR < 6)
+  std::string ErrorInfo;
+  raw_fd_ostream out(filename.c_str(), ErrorInfo, sys::fs::F_None);
+  if (!ErrorInfo.empty()) {
+    errs() << "Cannot open '" << filename << "': " << ErrorInfo << "\n";
+    return false;
+  }
+#else
+  std::error_code EC;
+  raw_fd_ostream out(filename, EC, sys::fs::F_None);
+  if (EC) {
+    errs() << "Cannot open '" << filename << "': " << EC.message() << "\n";
+    return false;
+  }
+#endif
+
+  out << data;
+  return true;
+}
+
+static bool is_nondet_function(const Function *callee)
+{
+  StringRef name = callee->getName();
+  return name.startswith("__VERIFIER_nondet") || name.startswith("nondet_")
+         || name.equals("klee_int");
+}
+
+// Analysis only: estimate how expensive the verification
+// of the module will be. Counts what the other passes of svc15 and the
+// models from lib/ would introduce without changing anything, so that
+// a scheduler can choose the options, timeout or a different tool.
+class EstimateCost : public ModulePass {
+  struct Cost {
+    uint64_t symbolic_bytes;
+    // allocations with non-constant size, we don't know the bytes
+    uint64_t symbolic_size_allocations;
+    uint64_t nondet_calls;
+    uint64_t allocation_sites;
+    uint64_t nondet_loops;
+    uint64_t undefined_calls;
+    uint64_t undefined_functions;
+    uint64_t uninitialized_allocas;
+    uint64_t functions;
+    uint64_t instructions;
+
+    Cost() : symbolic_bytes(0), symbolic_size_allocations(0), nondet_calls(0),
+             allocation_sites(0), nondet_loops(0), undefined_calls(0),
+             undefined_functions(0), uninitialized_allocas(0), functions(0),
+             instructions(0) {}
+  };
+
+  void countFunction(Function &F, DataLayout *DL, Cost& cost,
+                     std::set<const Function *>& undefined);
+  static bool isNondetSource(const Instruction *I);
+
+  public:
+    static char ID;
+
+    EstimateCost() : ModulePass(ID) {}
+
+    virtual bool runOnModule(Module &M);
+    virtual void getAnalysisUsage(AnalysisUsage &AU) const;
+};
+
+static RegisterPass<EstimateCost> ESTCOST("estimate-cost",
+                                          "estimate the cost of verification (analysis only)");
+char EstimateCost::ID;
+
+void EstimateCost::getAnalysisUsage(AnalysisUsage &AU) const
+{
+  AU.setPreservesAll();
+#if (LLVM_VERSION_MINOR < 7)
+  AU.addRequired<LoopInfo>();
+#else
+  AU.addRequired<LoopInfoWrapperPass>();
+#endif
+}
+
+bool EstimateCost::isNondetSource(const Instruction *I)
+{
+  const CallInst *CI = dyn_cast<CallInst>(I);
+  if (!CI)
+    return false;
+
+  const Function *callee = get_called_function(CI);
+  return callee && (is_nondet_function(callee) || is_removed_undefined(callee));
+}
+
+void EstimateCost::countFunction(Function &F, DataLayout *DL, Cost& cost,
+                                 std::set<const Function *>& undefined)
+{
+  for (inst_iterator I = inst_begin(F), E = inst_end(F); I != E; ++I) {
+    Instruction *ins = &*I;
+    ++cost.instructions;
+
+    // initialize-uninitialized
+    if (AllocaInst *AI = dyn_cast<AllocaInst>(ins)) {
+      if (AI->getAllocatedType()->isSized()) {
+        ++cost.uninitialized_allocas;
+        cost.symbolic_bytes += DL->getTypeAllocSize(AI->getAllocatedType());
+      }
+      continue;
+    }
+
+    CallInst *CI = dyn_cast<CallInst>(ins);
+    if (!CI)
+      continue;
+
+    const Function *callee = get_called_function(CI);
+    if (!callee)
+      continue;
+
+    StringRef name = callee->getName();
+    Type *RetTy = CI->getType();
+
+    if (is_nondet_function(callee)) {
+      ++cost.nondet_calls;
+      if (RetTy->isSized())
+        cost.symbolic_bytes += DL->getTypeAllocSize(RetTy);
+    } else if (is_removed_undefined(callee)) {
+      // delete-undefined
+      ++cost.undefined_calls;
+      undefined.insert(callee);
+      if (RetTy->isSized())
+        cost.symbolic_bytes += DL->getTypeAllocSize(RetTy);
+    } else if (name.equals("malloc")) {
+      // instrument-alloc, every allocation may fail
+      ++cost.allocation_sites;
+      if (is_overwritten_before_read(CI, DL))
+        continue;
+
+      if (ConstantInt *Size = dyn_cast<ConstantInt>(CI->getArgOperand(0)))
+        cost.symbolic_bytes += Size->getZExtValue();
+      else
+        ++cost.symbolic_size_allocations;
+    } else if (name.equals("calloc")) {
+      ++cost.allocation_sites;
+      if (!symbolic_calloc)
+        continue;
+
+      ConstantInt *Num = dyn_cast<ConstantInt>(CI->getArgOperand(0));
+      ConstantInt *Size = dyn_cast<ConstantInt>(CI->getArgOperand(1));
+      if (Num && Size)
+        cost.symbolic_bytes += Num->getZExtValue() * Size->getZExtValue();
+      else
+        ++cost.symbolic_size_allocations;
+    } else if (name.equals("klee_make_symbolic")) {
+      if (ConstantInt *Size = dyn_cast<ConstantInt>(CI->getArgOperand(1)))
+        cost.symbolic_bytes += Size->getZExtValue();
+      else
+        ++cost.symbolic_size_allocations;
+    }
+  }
+
+#if (LLVM_VERSION_MINOR < 7)
+  LoopInfo &LI = getAnalysis<LoopInfo>(F);
+#else
+  LoopInfo &LI = getAnalysis<LoopInfoWrapperPass>(F).getLoopInfo();
+#endif
+
+  // count all loops, including the nested ones, that
+  // get a new nondeterministic value in each iteration
+  std::vector<Loop *> loops(LI.begin(), LI.end());
+  while (!loops.empty()) {
+    Loop *L = loops.back();
+    loops.pop_back();
+    loops.insert(loops.end(), L->begin(), L->end());
+
+    bool has_nondet = false;
+    for (Loop::block_iterator B = L->block_begin(), BE = L->block_end();
+         B != BE && !has_nondet; ++B)
+      for (BasicBlock::iterator I = (*B)->begin(), IE = (*B)->end(); I != IE; ++I)
+        if (isNondetSource(&*I)) {
+          has_nondet = true;
+          break;
+        }
+
+    if (has_nondet)
+      ++cost.nondet_loops;
+  }
+}
+
+bool EstimateCost::runOnModule(Module &M)
+{
+  DataLayout *DL = new DataLayout(M.getDataLayout());
+  std::set<const Function *> undefined;
+  Cost cost;
+
+  for (Module::iterator F = M.begin(), E = M.end(); F != E; ++F) {
+    if (F->isDeclaration())
+      continue;
+
+    ++cost.functions;
+    countFunction(*F, DL, cost, undefined);
+  }
+
+  cost.undefined_functions = undefined.size();
   delete DL;
+
+  std::string data;
+  raw_string_ostream out(data);
+  out << "{\n"
+      << "  \"symbolic_bytes\": " << cost.symbolic_bytes << ",\n"
+      << "  \"symbolic_size_allocations\": " << cost.symbolic_size_allocations << ",\n"
+      << "  \"nondet_calls\": " << cost.nondet_calls << ",\n"
+      << "  \"allocation_sites\": " << cost.allocation_sites << ",\n"
+      << "  \"nondet_loops\": " << cost.nondet_loops << ",\n"
+      << "  \"undefined_calls\": " << cost.undefined_calls << ",\n"
+      << "  \"undefined_functions\": " << cost.undefined_functions << ",\n"
+      << "  \"uninitialized_allocas\": " << cost.uninitialized_allocas << ",\n"
+      << "  \"functions\": " << cost.functions << ",\n"
+      << "  \"instructions\": " << cost.instructions << "\n"
+      << "}\n";
+  out.flush();
+
+  if (!write_output(cost_output, data))
+    report_fatal_error("EstimateCost: cannot write the cost vector");
+  return false;
+}
+
+// Klee forks on the code between a nondeterministic value and
+// an assume that constrains it, only to kill the infeasible paths
+// at the assume. Move the assumes (together with the computation
+// of their condition) up, also to the dominating blocks past branches
+// that always join again before the assume, as long as the code in
+// between has no side effects visible before the assume and can not trap.
+class HoistAssume : public FunctionPass {
+  unsigned hoisted;
+
+  public:
+    static char ID;
+
+    HoistAssume() : FunctionPass(ID), hoisted(0) {}
+
+    virtual bool runOnFunction(Function &F);
+    virtual bool doFinalization(Module &M);
+    virtual void getAnalysisUsage(AnalysisUsage &AU) const;
+};
+
+static RegisterPass<HoistAssume> HOISTASM("hoist-assume",
+                                          "move assumes as early as possible");
+char HoistAssume::ID;
+
+void HoistAssume::getAnalysisUsage(AnalysisUsage &AU) const
+{
+#if (LLVM_VERSION_MINOR < 5)
+  AU.addRequired<DominatorTree>();
+#else
+  AU.addRequired<DominatorTreeWrapperPass>();
+#endif
+}
+
+static bool is_assume(const CallInst *CI)
+{
+  const Function *callee = get_called_function(CI);
+  if (!callee)
+    return false;
+
+  StringRef name = callee->getName();
+  return name.equals("__VERIFIER_assume") || name.equals("klee_assume");
+}
+
+// what we know about the code the assume is moved above
+struct HoistState {
+  // the computation of the condition
+  std::set<Instruction *> cone;
+  // the part of the cone that moves together with the assume
+  std::set<Instruction *> to_move;
+  // memory read by the moved loads, a store to it stops the motion
+  std::set<const Value *> loaded;
+  bool loads_unknown;
+  // blocks that the assume was already moved out of (or above)
+  std::set<BasicBlock *> visited;
+
+  HoistState() : loads_unknown(false) {}
+};
+
+static void add_moved_load(LoadInst *LI, HoistState &S)
+{
+  const Value *obj = LI->getPointerOperand()->stripInBoundsOffsets();
+  if (isa<AllocaInst>(obj) || isa<GlobalVariable>(obj))
+    S.loaded.insert(obj);
+  else
+    S.loads_unknown = true;
+}
+
+static bool is_stored_loaded(StoreInst *SI, HoistState &S)
+{
+  return S.loads_unknown || S.loaded.count(SI->getPointerOperand());
+}
+
+// can the assume be moved above I? If I computes the condition,
+// it is moved too. Does not check stores against the moved loads
+static bool can_pass(Instruction *I, HoistState &S)
+{
+  if (isa<DbgInfoIntrinsic>(I))
+    return true;
+
+  if (S.cone.count(I)) {
+    // the value of a phi depends on the path that we skip
+    if (isa<PHINode>(I) || !isSafeToSpeculativelyExecute(I))
+      return false;
+
+    if (LoadInst *LI = dyn_cast<LoadInst>(I))
+      add_moved_load(LI, S);
+
+    S.to_move.insert(I);
+    return true;
+  }
+
+  // branches that join again before the assume (checked by the caller)
+  if (isa<PHINode>(I) || isa<BranchInst>(I) || isa<SwitchInst>(I))
+    return true;
+
+  // a store to a local variable can not trap
+  // and nobody sees it before the assume
+  if (StoreInst *SI = dyn_cast<StoreInst>(I))
+    return !SI->isVolatile() && isa<AllocaInst>(SI->getPointerOperand());
+
+  return isSafeToSpeculativelyExecute(I);
+}
+
+// scan the block from It up. Return the last instruction
+// that can not be passed or NULL if we can pass the whole block
+static Instruction *scan_up(BasicBlock *B, BasicBlock::iterator It, HoistState &S)
+{
+  while (It != B->begin()) {
+    --It;
+    Instruction *I = &*It;
+
+    if (!can_pass(I, S))
+      return I;
+
+    if (StoreInst *SI = dyn_cast<StoreInst>(I))
+      if (is_stored_loaded(SI, S))
+        return I;
+  }
+
+  return NULL;
+}
+
+// the blocks between D and its dominated block B, all paths from D
+// must reach B and the code on them must be passable by the assume.
+// Blocks on the paths after B (i.e. loops around the assume)
+// make us give up.
+static bool pass_region(BasicBlock *D, BasicBlock *B, HoistState &S)
+{
+  std::set<BasicBlock *> region;
+  std::vector<BasicBlock *> worklist;
+
+  worklist.push_back(B);
+  while (!worklist.empty()) {
+    BasicBlock *cur = worklist.back();
+    worklist.pop_back();
+
+    for (pred_iterator P = pred_begin(cur), PE = pred_end(cur); P != PE; ++P) {
+      BasicBlock *pred = *P;
+      if (pred == D)
+        continue;
+
+      if (S.visited.count(pred))
+        return false;
+
+      if (region.insert(pred).second)
+        worklist.push_back(pred);
+    }
+  }
+
+  region.insert(D);
+  for (std::set<BasicBlock *>::iterator I = region.begin(), E = region.end();
+       I != E; ++I) {
+    TerminatorInst *T = (*I)->getTerminator();
+    if (!isa<BranchInst>(T) && !isa<SwitchInst>(T))
+      return false;
+
+    for (unsigned i = 0; i < T->getNumSuccessors(); ++i)
+      if (T->getSuccessor(i) != B && !region.count(T->getSuccessor(i)))
+        return false;
+  }
+  region.erase(D);
+
+  // we do not know the order of the blocks, so take every store
+  // in the region as if it was above every load in the region
+  HoistState tmp = S;
+  std::vector<StoreInst *> stores;
+  for (std::set<BasicBlock *>::iterator I = region.begin(), E = region.end();
+       I != E; ++I) {
+    for (BasicBlock::iterator It = (*I)->begin(), IE = (*I)->end(); It != IE; ++It) {
+      if (!can_pass(&*It, tmp))
+        return false;
+
+      if (StoreInst *SI = dyn_cast<StoreInst>(&*It))
+        stores.push_back(SI);
+    }
+  }
+
+  for (std::vector<StoreInst *>::iterator I = stores.begin(), E = stores.end();
+       I != E; ++I)
+    if (is_stored_loaded(*I, tmp))
+      return false;
+
+  tmp.visited.insert(region.begin(), region.end());
+  tmp.visited.insert(D);
+  S = tmp;
+  return true;
+}
+
+// move I (after the instructions it uses) before InsertBefore
+static void move_cone(Instruction *I, Instruction *InsertBefore, HoistState &S)
+{
+  if (!S.to_move.erase(I))
+    return;
+
+  for (User::op_iterator O = I->op_begin(), OE = I->op_end(); O != OE; ++O)
+    if (Instruction *Op = dyn_cast<Instruction>(*O))
+      move_cone(Op, InsertBefore, S);
+
+  I->moveBefore(InsertBefore);
+}
+
+static bool hoist_assume(CallInst *CI, DominatorTree &DT)
+{
+  HoistState S;
+  std::vector<Instruction *> worklist;
+
+  // the computation of the condition. Instructions that can
+  // not be moved are left out by can_pass() and stop the motion
+  worklist.push_back(CI);
+  while (!worklist.empty()) {
+    Instruction *I = worklist.back();
+    worklist.pop_back();
+
+    if (isa<PHINode>(I))
+      continue;
+
+    for (User::op_iterator O = I->op_begin(), OE = I->op_end(); O != OE; ++O) {
+      Instruction *Op = dyn_cast<Instruction>(*O);
+      if (Op && S.cone.insert(Op).second)
+        worklist.push_back(Op);
+    }
+  }
+
+  BasicBlock *B = CI->getParent();
+  S.visited.insert(B);
+
+  Instruction *barrier = scan_up(B, BasicBlock::iterator(CI), S);
+  while (!barrier) {
+    DomTreeNode *N = DT.getNode(B);
+    if (!N || !N->getIDom())
+      break;
+
+    BasicBlock *D = N->getIDom()->getBlock();
+    if (!pass_region(D, B, S))
+      break;
+
+    B = D;
+    barrier = scan_up(B, B->end(), S);
+  }
+
+  // insert right after the barrier, but after the phis and not
+  // before an instruction that we move ourselves
+  BasicBlock::iterator It = B->begin();
+  if (barrier) {
+    It = BasicBlock::iterator(barrier);
+    ++It;
+  }
+
+  while (isa<PHINode>(&*It) || S.to_move.count(&*It))
+    ++It;
+
+  Instruction *InsertBefore = &*It;
+  if (InsertBefore == CI)
+    return false;
+
+  while (!S.to_move.empty())
+    move_cone(*S.to_move.begin(), InsertBefore, S);
+  CI->moveBefore(InsertBefore);
+
+  return true;
+}
+
+bool HoistAssume::runOnFunction(Function &F)
+{
+#if (LLVM_VERSION_MINOR < 5)
+  DominatorTree &DT = getAnalysis<DominatorTree>();
+#else
+  DominatorTree &DT = getAnalysis<DominatorTreeWrapperPass>().getDomTree();
+#endif
+  std::vector<CallInst *> assumes;
+  bool modified = false;
+
+  for (inst_iterator I = inst_begin(F), E = inst_end(F); I != E; ++I)
+    if (CallInst *CI = dyn_cast<CallInst>(&*I))
+      if (is_assume(CI))
+        assumes.push_back(CI);
+
+  // we only move instructions, the dominator tree stays valid
+  for (std::vector<CallInst *>::iterator I = assumes.begin(), E = assumes.end();
+       I != E; ++I) {
+    if (hoist_assume(*I, DT)) {
+      ++hoisted;
+      modified = true;
+    }
+  }
+
   return modified;
 }
+
+bool HoistAssume::doFinalization(Module &M)
+{
+  (void) M;
+  errs() << "HoistAssume: hoisted " << hoisted << " assumes\n";
+  return false;
+}
+
+// Interprocedural cone of influence of the error sites. A value is
+// relevant if it can influence whether __VERIFIER_error/__assert_fail
+// is reached or the argument of __VERIFIER_assert (or of an assume, since
+// that cuts paths). Klee also checks some operations on its own
+// (division by zero, oversized shifts, memory accesses), so their
+// operands are relevant too, otherwise a concrete value could make the
+// check fail on every path. Nondeterministic values that are not relevant
+// are replaced by concrete ones, so that we do not need the slicer
+// to remove them.
+//
+// The control dependence is approximated by functions: once anything
+// in a function is relevant, all its branch conditions are relevant
+// and so are the calls of the function. Memory is tracked per object
+// (alloca, global, allocation call). If a relevant value is read from
+// memory that we can not assign to objects, the module is left as is.
+class NondetCOI : public ModulePass {
+  std::map<const Function *, std::vector<CallInst *> > call_sites;
+  std::vector<CallInst *> indirect_calls;
+  // instructions writing to the object
+  std::map<Value *, std::vector<Instruction *> > object_writes;
+  // instructions writing to memory we know nothing about
+  std::vector<Instruction *> unknown_writes;
+
+  std::set<Value *> relevant;
+  std::set<Value *> relevant_objects;
+  std::set<const Function *> relevant_control;
+  std::vector<Value *> worklist;
+  // objects whose address gets where we do not follow it,
+  // pointers with unknown base may point to them
+  std::set<Value *> escaped;
+  bool escaped_relevant;
+
+  void collectBases(Value *P, std::set<Value *>& objs, bool& unknown,
+                    std::set<Value *>& visited);
+  void getBases(Value *P, std::set<Value *>& objs, bool& unknown);
+  void addWrite(Value *P, Instruction *W);
+  void buildWrites(Module &M);
+  void findEscaped(Module &M);
+  void addCriteria(Module &M);
+  void addImplicitChecks(Instruction *I);
+
+  void markValue(Value *V);
+  void markObject(Value *O);
+  void markObjects(Value *P);
+  void markControl(const Function *F);
+  void process(Value *V);
+
+  bool makeConcrete(Module &M);
+
+  public:
+    static char ID;
+
+    NondetCOI() : ModulePass(ID), escaped_relevant(false) {}
+
+    virtual bool runOnModule(Module &M);
+};
+
+static RegisterPass<NondetCOI> NDCOI("nondet-coi",
+                                     "make nondeterministic values that can not influence "
+                                     "reaching an error concrete");
+char NondetCOI::ID;
+
+static Value *strip_to_base(Value *P)
+{
+  while (true) {
+    P = P->stripPointerCasts();
+    if (GEPOperator *GEP = dyn_cast<GEPOperator>(P))
+      P = GEP->getPointerOperand();
+    else
+      return P;
+  }
+}
+
+void NondetCOI::collectBases(Value *P, std::set<Value *>& objs, bool& unknown,
+                             std::set<Value *>& visited)
+{
+  P = strip_to_base(P);
+  if (!visited.insert(P).second)
+    return;
+
+  if (isa<AllocaInst>(P) || isa<GlobalVariable>(P)) {
+    objs.insert(P);
+  } else if (isa<ConstantPointerNull>(P) || isa<UndefValue>(P)) {
+    // no object
+  } else if (PHINode *PN = dyn_cast<PHINode>(P)) {
+    for (unsigned i = 0; i < PN->getNumIncomingValues(); ++i)
+      collectBases(PN->getIncomingValue(i), objs, unknown, visited);
+  } else if (SelectInst *SI = dyn_cast<SelectInst>(P)) {
+    collectBases(SI->getTrueValue(), objs, unknown, visited);
+    collectBases(SI->getFalseValue(), objs, unknown, visited);
+  } else if (CallInst *CI = dyn_cast<CallInst>(P)) {
+    const Function *callee = get_called_function(CI);
+    if (!callee) {
+      unknown = true;
+    } else if (callee->isDeclaration()) {
+      // allocation (or some other undefined function), the call is the object
+      objs.insert(CI);
+    } else {
+      for (Function::const_iterator B = callee->begin(), BE = callee->end(); B != BE; ++B)
+        if (const ReturnInst *RI = dyn_cast<ReturnInst>(B->getTerminator()))
+          if (RI->getReturnValue())
+            collectBases(RI->getReturnValue(), objs, unknown, visited);
+    }
+  } else if (Argument *A = dyn_cast<Argument>(P)) {
+    const Function *F = A->getParent();
+    if (F->hasAddressTaken()) {
+      unknown = true;
+      return;
+    }
+
+    std::vector<CallInst *>& calls = call_sites[F];
+    for (std::vector<CallInst *>::iterator I = calls.begin(), E = calls.end(); I != E; ++I)
+      if ((*I)->getNumArgOperands() > A->getArgNo())
+        collectBases((*I)->getArgOperand(A->getArgNo()), objs, unknown, visited);
+  } else {
+    // loaded pointers, inttoptr, ...
+    unknown = true;
+  }
+}
+
+void NondetCOI::getBases(Value *P, std::set<Value *>& objs, bool& unknown)
+{
+  std::set<Value *> visited;
+  unknown = false;
+  collectBases(P, objs, unknown, visited);
+}
+
+void NondetCOI::addWrite(Value *P, Instruction *W)
+{
+  std::set<Value *> objs;
+  bool unknown;
+
+  getBases(P, objs, unknown);
+  if (unknown)
+    unknown_writes.push_back(W);
+
+  for (std::set<Value *>::iterator I = objs.begin(), E = objs.end(); I != E; ++I)
+    object_writes[*I].push_back(W);
+}
+
+void NondetCOI::buildWrites(Module &M)
+{
+  for (Module::iterator F = M.begin(), FE = M.end(); F != FE; ++F) {
+    for (inst_iterator I = inst_begin(*F), E = inst_end(*F); I != E; ++I) {
+      CallInst *CI = dyn_cast<CallInst>(&*I);
+      if (!CI || CI->isInlineAsm())
+        continue;
+
+      if (Function *callee = dyn_cast<Function>(CI->getCalledValue()->stripPointerCasts()))
+        call_sites[callee].push_back(CI);
+      else
+        indirect_calls.push_back(CI);
+    }
+  }
+
+  // we need all call sites to find the objects
+  for (Module::iterator F = M.begin(), FE = M.end(); F != FE; ++F) {
+    for (inst_iterator I = inst_begin(*F), E = inst_end(*F); I != E; ++I) {
+      Instruction *ins = &*I;
+
+      if (StoreInst *SI = dyn_cast<StoreInst>(ins)) {
+        addWrite(SI->getPointerOperand(), SI);
+        continue;
+      }
+
+      if (MemIntrinsic *MI = dyn_cast<MemIntrinsic>(ins)) {
+        addWrite(MI->getRawDest(), MI);
+        continue;
+      }
+
+      CallInst *CI = dyn_cast<CallInst>(ins);
+      if (!CI)
+        continue;
+
+      // stores in defined functions are handled on their own,
+      // klee_make_symbolic is the source we are interested in
+      const Function *callee = get_called_function(CI);
+      if (callee && (!callee->isDeclaration()
+                     || callee->getName().equals("klee_make_symbolic")
+                     || callee->getName().equals("free")
+                     || callee->getName().equals("__VERIFIER_free")))
+        continue;
+
+      // undefined function may write to any memory we give it
+      for (unsigned i = 0; i < CI->getNumArgOperands(); ++i)
+        if (CI->getArgOperand(i)->getType()->isPointerTy())
+          addWrite(CI->getArgOperand(i), CI);
+    }
+  }
+}
+
+// is the address in V used for anything else than loading
+// and storing (through casts and GEPs), so that we lose track of it?
+static bool is_escaping(Value *V, std::set<Value *>& visited)
+{
+  if (!visited.insert(V).second)
+    return false;
+
+#if (LLVM_VERSION_MINOR < 5)
+  for (Value::use_iterator U = V->use_begin(), E = V->use_end(); U != E; ++U) {
+#else
+  for (Value::user_iterator U = V->user_begin(), E = V->user_end(); U != E; ++U) {
+#endif
+    if (isa<LoadInst>(*U) || isa<ICmpInst>(*U))
+      continue;
+
+    if (StoreInst *SI = dyn_cast<StoreInst>(*U)) {
+      if (SI->getValueOperand() == V)
+        return true;
+      continue;
+    }
+
+    // instructions as well as constant expressions
+    if (isa<BitCastOperator>(*U) || isa<GEPOperator>(*U)
+        || isa<PHINode>(*U) || isa<SelectInst>(*U)) {
+      if (is_escaping(*U, visited))
+        return true;
+      continue;
+    }
+
+    // memset, memcpy, lifetime markers, debug info
+    if (isa<IntrinsicInst>(*U))
+      continue;
+
+    if (CallInst *CI = dyn_cast<CallInst>(*U)) {
+      const Function *callee = get_called_function(CI);
+      if (callee && callee->getName().equals("klee_make_symbolic"))
+        continue;
+    }
+
+    // passed to a function, stored, returned, converted to integer
+    // or used in an initializer of a global
+    return true;
+  }
+
+  return false;
+}
+
+void NondetCOI::findEscaped(Module &M)
+{
+  std::set<Value *> visited;
+
+  for (Module::global_iterator G = M.global_begin(), GE = M.global_end(); G != GE; ++G) {
+    visited.clear();
+    if (is_escaping(&*G, visited))
+      escaped.insert(&*G);
+  }
+
+  for (Module::iterator F = M.begin(), FE = M.end(); F != FE; ++F) {
+    for (inst_iterator I = inst_begin(*F), E = inst_end(*F); I != E; ++I) {
+      Instruction *ins = &*I;
+
+      // the objects as collectBases finds them
+      if (CallInst *CI = dyn_cast<CallInst>(ins)) {
+        const Function *callee = get_called_function(CI);
+        if (!callee || !callee->isDeclaration() || !CI->getType()->isPointerTy())
+          continue;
+      } else if (!isa<AllocaInst>(ins)) {
+        continue;
+      }
+
+      visited.clear();
+      if (is_escaping(ins, visited))
+        escaped.insert(ins);
+    }
+  }
+}
+
+void NondetCOI::addCriteria(Module &M)
+{
+  static const char *error_calls[] = {
+    "__VERIFIER_error",
+    "__assert_fail",
+    // these stop the path
+    "abort",
+    "exit",
+    "_exit",
+    "klee_abort",
+    "klee_silent_exit",
+    "klee_report_error",
+    NULL
+  };
+  static const char *condition_calls[] = {
+    "__VERIFIER_assert",
+    "__VERIFIER_assume",
+    "klee_assume",
+    NULL
+  };
+
+  for (Module::iterator F = M.begin(), FE = M.end(); F != FE; ++F) {
+    for (inst_iterator I = inst_begin(*F), E = inst_end(*F); I != E; ++I) {
+      addImplicitChecks(&*I);
+
+      CallInst *CI = dyn_cast<CallInst>(&*I);
+      if (!CI)
+        continue;
+
+      const Function *callee = get_called_function(CI);
+      if (!callee)
+        continue;
+
+      StringRef name = callee->getName();
+      if (array_match(name, error_calls)) {
+        markControl(&*F);
+      } else if (array_match(name, condition_calls)) {
+        markControl(&*F);
+        if (CI->getNumArgOperands() > 0)
+          markValue(CI->getArgOperand(0));
+      }
+    }
+  }
+}
+
+// is P an in-bounds constant offset into an alloca or a global,
+// so that klee's check of the access can not fail?
+static bool is_safe_access(Value *P)
+{
+  Value *base = P->stripInBoundsConstantOffsets();
+  return isa<AllocaInst>(base) || isa<GlobalVariable>(base);
+}
+
+// operands that klee checks itself, the checks are error sites as well
+void NondetCOI::addImplicitChecks(Instruction *I)
+{
+  std::vector<Value *> checked;
+
+  if (BinaryOperator *BO = dyn_cast<BinaryOperator>(I)) {
+    switch (BO->getOpcode()) {
+      // division by zero
+      case Instruction::SDiv:
+      case Instruction::UDiv:
+      case Instruction::SRem:
+      case Instruction::URem:
+      // shift by more than the bit width
+      case Instruction::Shl:
+      case Instruction::LShr:
+      case Instruction::AShr:
+        if (!isa<Constant>(BO->getOperand(1)))
+          checked.push_back(BO->getOperand(1));
+        break;
+      default:
+        break;
+    }
+  } else if (LoadInst *LI = dyn_cast<LoadInst>(I)) {
+    if (!is_safe_access(LI->getPointerOperand()))
+      checked.push_back(LI->getPointerOperand());
+  } else if (StoreInst *SI = dyn_cast<StoreInst>(I)) {
+    if (!is_safe_access(SI->getPointerOperand()))
+      checked.push_back(SI->getPointerOperand());
+  } else if (MemIntrinsic *MI = dyn_cast<MemIntrinsic>(I)) {
+    checked.push_back(MI->getRawDest());
+    checked.push_back(MI->getLength());
+    if (MemTransferInst *MTI = dyn_cast<MemTransferInst>(MI))
+      checked.push_back(MTI->getRawSource());
+  } else if (CallInst *CI = dyn_cast<CallInst>(I)) {
+    // invalid and double free
+    const Function *callee = get_called_function(CI);
+    if (callee && CI->getNumArgOperands() > 0 &&
+        (callee->getName().equals("free") ||
+         callee->getName().equals("__VERIFIER_free") ||
+         callee->getName().equals("realloc") ||
+         callee->getName().equals("__VERIFIER_realloc")))
+      checked.push_back(CI->getArgOperand(0));
+  }
+
+  if (checked.empty())
+    return;
+
+  // whether the check is reached matters too
+  markControl(I->getParent()->getParent());
+  for (std::vector<Value *>::iterator V = checked.begin(), VE = checked.end();
+       V != VE; ++V)
+    markValue(*V);
+}
+
+void NondetCOI::markValue(Value *V)
+{
+  if (!isa<Instruction>(V) && !isa<Argument>(V))
+    return;
+
+  if (relevant.insert(V).second)
+    worklist.push_back(V);
+}
+
+void NondetCOI::markObject(Value *O)
+{
+  if (!relevant_objects.insert(O).second)
+    return;
+
+  // the first relevant object, writes to unknown memory may write to it
+  if (relevant_objects.size() == 1)
+    for (std::vector<Instruction *>::iterator W = unknown_writes.begin(),
+         WE = unknown_writes.end(); W != WE; ++W)
+      markValue(*W);
+
+  std::vector<Instruction *>& writes = object_writes[O];
+  for (std::vector<Instruction *>::iterator W = writes.begin(), WE = writes.end();
+       W != WE; ++W)
+    markValue(*W);
+}
+
+// the memory pointed to by P is read
+void NondetCOI::markObjects(Value *P)
+{
+  std::set<Value *> objs;
+  bool unknown;
+
+  getBases(P, objs, unknown);
+
+  // we do not know where P comes from, but it can point
+  // only to an object whose address escaped
+  if (unknown && !escaped_relevant) {
+    escaped_relevant = true;
+    for (std::set<Value *>::iterator I = escaped.begin(), E = escaped.end(); I != E; ++I)
+      markObject(*I);
+  }
+
+  for (std::set<Value *>::iterator I = objs.begin(), E = objs.end(); I != E; ++I)
+    markObject(*I);
+}
+
+void NondetCOI::markControl(const Function *F)
+{
+  if (!relevant_control.insert(F).second)
+    return;
+
+  for (Function::const_iterator B = F->begin(), BE = F->end(); B != BE; ++B) {
+    const TerminatorInst *T = B->getTerminator();
+    if (const BranchInst *BI = dyn_cast<BranchInst>(T)) {
+      if (BI->isConditional())
+        markValue(BI->getCondition());
+    } else if (const SwitchInst *SI = dyn_cast<SwitchInst>(T)) {
+      markValue(SI->getCondition());
+    } else if (const IndirectBrInst *IBI = dyn_cast<IndirectBrInst>(T)) {
+      markValue(IBI->getAddress());
+    }
+  }
+
+  // and whether the function is called at all
+  std::vector<CallInst *>& calls = call_sites[F];
+  for (std::vector<CallInst *>::iterator I = calls.begin(), E = calls.end(); I != E; ++I)
+    markControl((*I)->getParent()->getParent());
+
+  if (F->hasAddressTaken())
+    for (std::vector<CallInst *>::iterator I = indirect_calls.begin(),
+         E = indirect_calls.end(); I != E; ++I) {
+      markValue((*I)->getCalledValue());
+      markControl((*I)->getParent()->getParent());
+    }
+}
+
+void NondetCOI::process(Value *V)
+{
+  if (Argument *A = dyn_cast<Argument>(V)) {
+    const Function *F = A->getParent();
+    std::vector<CallInst *>& calls = call_sites[F];
+    for (std::vector<CallInst *>::iterator I = calls.begin(), E = calls.end(); I != E; ++I)
+      if ((*I)->getNumArgOperands() > A->getArgNo())
+        markValue((*I)->getArgOperand(A->getArgNo()));
+
+    if (F->hasAddressTaken())
+      for (std::vector<CallInst *>::iterator I = indirect_calls.begin(),
+           E = indirect_calls.end(); I != E; ++I)
+        if ((*I)->getNumArgOperands() > A->getArgNo())
+          markValue((*I)->getArgOperand(A->getArgNo()));
+    return;
+  }
+
+  Instruction *I = cast<Instruction>(V);
+  markControl(I->getParent()->getParent());
+
+  if (LoadInst *LI = dyn_cast<LoadInst>(I)) {
+    markValue(LI->getPointerOperand());
+    markObjects(LI->getPointerOperand());
+    return;
+  }
+
+  if (CallInst *CI = dyn_cast<CallInst>(I)) {
+    const Function *callee = get_called_function(CI);
+    if (callee && !callee->isDeclaration()) {
+      // the arguments are marked when used in the callee
+      for (Function::const_iterator B = callee->begin(), BE = callee->end(); B != BE; ++B)
+        if (const ReturnInst *RI = dyn_cast<ReturnInst>(B->getTerminator()))
+          if (RI->getReturnValue())
+            markValue(RI->getReturnValue());
+      return;
+    }
+
+    // a source of nondeterminism, its value does not depend on anything
+    if (callee && is_nondet_function(callee))
+      return;
+
+    // undefined function, intrinsic, inline asm or indirect call,
+    // the result depends on everything it gets
+    markValue(CI->getCalledValue());
+    for (unsigned i = 0; i < CI->getNumArgOperands(); ++i) {
+      markValue(CI->getArgOperand(i));
+      if (CI->getArgOperand(i)->getType()->isPointerTy())
+        markObjects(CI->getArgOperand(i));
+    }
+    return;
+  }
+
+  for (User::op_iterator O = I->op_begin(), OE = I->op_end(); O != OE; ++O)
+    markValue(*O);
+}
+
+bool NondetCOI::makeConcrete(Module &M)
+{
+  unsigned total = 0, concrete = 0;
+
+  for (Module::iterator F = M.begin(), FE = M.end(); F != FE; ++F) {
+    for (inst_iterator I = inst_begin(*F), E = inst_end(*F); I != E;) {
+      CallInst *CI = dyn_cast<CallInst>(&*I);
+      ++I;
+      if (!CI)
+        continue;
+
+      const Function *callee = get_called_function(CI);
+      if (!callee)
+        continue;
+
+      StringRef name = callee->getName();
+      if (name.equals("klee_make_symbolic")) {
+        ++total;
+
+        std::set<Value *> objs;
+        bool unknown;
+        getBases(CI->getArgOperand(0), objs, unknown);
+        if (unknown)
+          continue;
+
+        bool is_relevant = false;
+        for (std::set<Value *>::iterator O = objs.begin(), OE = objs.end(); O != OE; ++O)
+          if (relevant_objects.count(*O))
+            is_relevant = true;
+
+        // klee gives the memory a concrete content
+        if (!is_relevant) {
+          CI->eraseFromParent();
+          ++concrete;
+        }
+      } else if (is_nondet_function(callee) && !CI->getType()->isVoidTy()) {
+        ++total;
+        if (!relevant.count(CI)) {
+          CI->replaceAllUsesWith(Constant::getNullValue(CI->getType()));
+          CI->eraseFromParent();
+          ++concrete;
+        }
+      } else if (name.equals("__VERIFIER_malloc") || name.equals("__VERIFIER_malloc0")) {
+        ++total;
+        if (!relevant_objects.count(CI)) {
+          Constant *C = M.getOrInsertFunction((name + "_concrete").str(),
+                                              callee->getFunctionType());
+          CI->setCalledFunction(C);
+          ++concrete;
+        }
+      }
+    }
+  }
+
+  errs() << "NondetCOI: made " << concrete << " of " << total
+         << " nondet sites concrete\n";
+  return concrete > 0;
+}
+
+bool NondetCOI::runOnModule(Module &M)
+{
+  buildWrites(M);
+  findEscaped(M);
+  addCriteria(M);
+
+  while (!worklist.empty()) {
+    Value *V = worklist.back();
+    worklist.pop_back();
+    process(V);
+  }
+
+  return makeConcrete(M);
+}
+
+static cl::opt<std::string> nondet_sites_output("nondet-sites-output",
+                                                cl::desc("File for the table of nondet sites "
+                                                         "(default: standard output)"),
+                                                cl::value_desc("filename"),
+                                                cl::init("-"));
+
+// Write the table of nondet sites recorded by the other passes,
+// one site per line: id, kind, file, line, function and type,
+// separated by tabs. The id is the number in the name of
+// the symbolic object in klee's tests (e.g. "nondet:12")
+class NondetSiteTable : public ModulePass {
+  public:
+    static char ID;
+
+    NondetSiteTable() : ModulePass(ID) {}
+
+    virtual bool runOnModule(Module &M);
+};
+
+static RegisterPass<NondetSiteTable> NDSITES("nondet-site-table",
+                                             "write the table of nondet sites");
+char NondetSiteTable::ID;
+
+bool NondetSiteTable::runOnModule(Module &M)
+{
+  std::string data;
+  raw_string_ostream out(data);
+
+  out << "# id\tkind\tfile\tline\tfunction\ttype\n";
+  if (NamedMDNode *sites = M.getNamedMetadata(nondet_sites_md)) {
+    for (unsigned i = 0; i < sites->getNumOperands(); ++i) {
+      MDNode *N = sites->getOperand(i);
+      if (MDString *rec = dyn_cast<MDString>(N->getOperand(0)))
+        out << rec->getString() << '\n';
+    }
+  }
+  out.flush();
+
+  if (!write_output(nondet_sites_output, data))
+    report_fatal_error("NondetSiteTable: cannot write the table of nondet sites");
+  return false;
+}
+
+static cl::opt<int> no_error_exit_code("no-error-exit-code",
+                                       cl::desc("exit status of check-error-reachable "
+                                                "when no error is reachable"),
+                                       cl::init(10));
+
+// If no error site is reachable from main, the answer is known
+// without running anything else. Print the verdict (on stderr) and exit
+// with -no-error-exit-code, otherwise do nothing.
+// Indirect calls (and calls to undefined functions that may call back)
+// are taken as calls to any function whose address is taken.
+class CheckErrorReachable : public ModulePass {
+  public:
+    static char ID;
+
+    CheckErrorReachable() : ModulePass(ID) {}
+
+    virtual bool runOnModule(Module &M);
+};
+
+static RegisterPass<CheckErrorReachable> CHKERR("check-error-reachable",
+                                                "exit with a verdict if no error is reachable from main");
+char CheckErrorReachable::ID;
+
+static bool is_error_function(const Function *F)
+{
+  StringRef name = F->getName();
+  return name.equals("__VERIFIER_error") || name.equals("__assert_fail")
+         || name.equals("__VERIFIER_assert");
+}
+
+static bool is_error_call(const CallInst *CI, const Function *callee)
+{
+  if (!is_error_function(callee))
+    return false;
+
+  // __VERIFIER_assert(1) can not fail
+  if (callee->getName().equals("__VERIFIER_assert")) {
+    const ConstantInt *C = CI->getNumArgOperands() > 0
+                           ? dyn_cast<ConstantInt>(CI->getArgOperand(0)) : NULL;
+    return !C || C->isZero();
+  }
+
+  return true;
+}
+
+static bool may_call_back(const CallInst *CI)
+{
+  for (unsigned i = 0; i < CI->getNumArgOperands(); ++i)
+    if (CI->getArgOperand(i)->getType()->isPointerTy())
+      return true;
+
+  return false;
+}
+
+static bool is_error_reachable(Module &M, Function *main)
+{
+  std::set<const Function *> reached;
+  std::vector<const Function *> worklist;
+  bool indirect_calls = false;
+  bool added_address_taken = false;
+
+  worklist.push_back(main);
+  reached.insert(main);
+
+  // constructors run before main and destructors after it
+  static const char *structors[] = {
+    "llvm.global_ctors",
+    "llvm.global_dtors",
+    NULL
+  };
+
+  for (const char **curr = structors; *curr; curr++)
+    if (GlobalVariable *GV = M.getNamedGlobal(*curr))
+      if (GV->hasInitializer())
+        for (User::op_iterator I = GV->getInitializer()->op_begin(),
+             E = GV->getInitializer()->op_end(); I != E; ++I)
+          if (ConstantStruct *CS = dyn_cast<ConstantStruct>(*I))
+            if (Function *F = dyn_cast<Function>(CS->getOperand(1)->stripPointerCasts()))
+              if (reached.insert(F).second)
+                worklist.push_back(F);
+
+  while (true) {
+    while (!worklist.empty()) {
+      const Function *F = worklist.back();
+      worklist.pop_back();
+
+      for (const_inst_iterator I = inst_begin(F), E = inst_end(F); I != E; ++I) {
+        const CallInst *CI = dyn_cast<CallInst>(&*I);
+        if (!CI || CI->isInlineAsm())
+          continue;
+
+        const Function *callee = dyn_cast<Function>(CI->getCalledValue()->stripPointerCasts());
+        if (!callee) {
+          indirect_calls = true;
+          continue;
+        }
+
+        if (is_error_call(CI, callee))
+          return true;
+
+        if (callee->isDeclaration()) {
+          if (!callee->isIntrinsic() && may_call_back(CI))
+            indirect_calls = true;
+          continue;
+        }
+
+        if (reached.insert(callee).second)
+          worklist.push_back(callee);
+      }
+    }
+
+    if (!indirect_calls || added_address_taken)
+      return false;
+
+    // any function whose address is taken may be called,
+    // we do not know the arguments of such call of __VERIFIER_assert
+    added_address_taken = true;
+    for (Module::iterator F = M.begin(), E = M.end(); F != E; ++F) {
+      if (!F->hasAddressTaken())
+        continue;
+
+      if (is_error_function(&*F))
+        return true;
+
+      if (!F->isDeclaration() && reached.insert(&*F).second)
+        worklist.push_back(&*F);
+    }
+  }
+}
+
+bool CheckErrorReachable::runOnModule(Module &M)
+{
+  Function *_main = find_main(M);
+  if (!_main) {
+    errs() << "CheckErrorReachable: no main function\n";
+    return false;
+  }
+
+  if (is_error_reachable(M, _main))
+    return false;
+
+  // the standard output may be the module
+  errs() << "no error reachable from main\n";
+  exit(no_error_exit_code);
+}
+
+// Alternative to initialize-uninitialized that runs after mem2reg/SROA.
+// Uninitialized locals are undef operands of phis, selects and other
+// instructions then, so replace the undefs with nondeterministic values
+// (a new one for every operand, distinct uninitialized locals must not
+// become equal) and keep the locals in registers.
+class InitializeUndef : public FunctionPass {
+  public:
+    static char ID;
+
+    InitializeUndef() : FunctionPass(ID) {}
+
+    virtual bool runOnFunction(Function &F);
+};
+
+static RegisterPass<InitializeUndef> INIUNDEF("initialize-undef",
+                                              "replace undef operands by non-deterministic values");
+char InitializeUndef::ID;
+
+// operands where undef is only a placeholder and does not
+// make the result nondeterministic if the program is correct
+static bool is_placeholder_undef(Instruction *I, unsigned idx)
+{
+  // building aggregates and vectors element by element
+  if (isa<InsertValueInst>(I) || isa<InsertElementInst>(I))
+    return idx == 0;
+
+  // the mask
+  if (isa<ShuffleVectorInst>(I))
+    return idx == 2;
+
+  return false;
+}
+
+bool InitializeUndef::runOnFunction(Function &F)
+{
+  if (F.isDeclaration())
+    return false;
+
+  Module *M = F.getParent();
+  LLVMContext& Ctx = M->getContext();
+  // a phi must have the same value for all edges from one block
+  std::map<std::pair<PHINode *, BasicBlock *>, unsigned> phi_nondets;
+  // the undef operands and the element of the frame they get
+  std::vector<std::pair<Use *, unsigned> > undefs;
+  std::vector<Type *> types;
+  Instruction *first = NULL;
+
+  for (inst_iterator I = inst_begin(F), E = inst_end(F); I != E; ++I) {
+    Instruction *ins = &*I;
+    if (isa<DbgInfoIntrinsic>(ins))
+      continue;
+
+    for (unsigned i = 0; i < ins->getNumOperands(); ++i) {
+      Value *Op = ins->getOperand(i);
+      if (!isa<UndefValue>(Op) || is_placeholder_undef(ins, i))
+        continue;
+
+      Type *Ty = Op->getType();
+      if (!Ty->isSized())
+        continue;
+
+      unsigned idx = types.size();
+      if (PHINode *PHI = dyn_cast<PHINode>(ins)) {
+        std::pair<std::map<std::pair<PHINode *, BasicBlock *>, unsigned>::iterator, bool> ret
+          = phi_nondets.insert(std::make_pair(std::make_pair(PHI, PHI->getIncomingBlock(i)), idx));
+        idx = ret.first->second;
+      }
+
+      if (idx == types.size())
+        types.push_back(Ty);
+
+      if (!first)
+        first = ins;
+
+      undefs.push_back(std::make_pair(&ins->getOperandUse(i), idx));
+    }
+  }
+
+  if (undefs.empty())
+    return false;
+
+  DataLayout *DL = new DataLayout(M->getDataLayout());
+  Instruction *InsertPt = &*F.getEntryBlock().getFirstInsertionPt();
+  Type *size_t_Ty;
+
+  if (DL->getPointerSizeInBits() > 32)
+    size_t_Ty = Type::getInt64Ty(Ctx);
+  else
+    size_t_Ty = Type::getInt32Ty(Ctx);
+
+  //void klee_make_symbolic(void *addr, size_t nbytes, const char *name);
+  Constant *C = M->getOrInsertFunction("klee_make_symbolic",
+                                       Type::getVoidTy(Ctx),
+                                       Type::getInt8PtrTy(Ctx), // addr
+                                       size_t_Ty,   // nbytes
+                                       Type::getInt8PtrTy(Ctx), // name
+                                       NULL);
+
+  // all the values come from one symbolic frame created in the entry
+  // block (so it dominates all uses), one klee_make_symbolic call and
+  // one symbolic array per activation of the function
+  StructType *FrameTy = StructType::get(Ctx, types);
+  AllocaInst *Frame = new AllocaInst(FrameTy, "nondet_undef_frame", InsertPt);
+
+  std::vector<Value *> args;
+  args.push_back(CastInst::CreatePointerCast(Frame, Type::getInt8PtrTy(Ctx), "", InsertPt));
+  args.push_back(ConstantInt::get(size_t_Ty, DL->getTypeAllocSize(FrameTy)));
+  args.push_back(get_site_name(M, "nondet_undef", first, FrameTy));
+  CallInst::Create(C, args, "", InsertPt);
+
+  std::vector<Value *> values;
+  for (unsigned i = 0; i < types.size(); ++i) {
+    Value *idx[] = {
+      ConstantInt::get(Type::getInt32Ty(Ctx), 0),
+      ConstantInt::get(Type::getInt32Ty(Ctx), i)
+    };
+    GetElementPtrInst *GEP = GetElementPtrInst::Create(Frame, idx, "", InsertPt);
+    values.push_back(new LoadInst(GEP, "nondet_undef", InsertPt));
+  }
+
+  for (unsigned i = 0; i < undefs.size(); ++i)
+    undefs[i].first->set(values[undefs[i].second]);
+
+  delete DL;
+  return true;
+}
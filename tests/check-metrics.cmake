@@ -0,0 +1,91 @@
+# Compile SOURCE, run the PASSES from PLUGIN on it and compare
+# the metrics of the output with BASELINE (see CMakeLists.txt)
+
+separate_arguments(PASSES)
+file(MAKE_DIRECTORY ${WORK_DIR})
+
+set(INPUT_BC ${WORK_DIR}/input.bc)
+set(OUTPUT_BC ${WORK_DIR}/output.bc)
+
+macro(run)
+  execute_process(COMMAND ${ARGN} RESULT_VARIABLE RET ERROR_VARIABLE ERR)
+  if (NOT RET EQUAL 0)
+    message(FATAL_ERROR "${ARGN} failed:\n${ERR}")
+  endif()
+endmacro()
+
+run(${CLANG} -c -emit-llvm -O0 ${SOURCE} -o ${INPUT_BC})
+run(${OPT} -load ${PLUGIN} ${PASSES} ${INPUT_BC} -o ${OUTPUT_BC})
+run(${LLVM_DIS} ${INPUT_BC} -o ${WORK_DIR}/input.ll)
+run(${LLVM_DIS} ${OUTPUT_BC} -o ${WORK_DIR}/output.ll)
+
+file(STRINGS ${WORK_DIR}/input.ll INPUT_LINES)
+file(STRINGS ${WORK_DIR}/output.ll OUTPUT_LINES)
+
+set(instructions 0)
+set(make_symbolic_sites 0)
+set(symbolic_bytes 0)
+set(input_globals 0)
+set(output_globals 0)
+
+foreach(LINE ${INPUT_LINES})
+  if (LINE MATCHES "^@")
+    math(EXPR input_globals "${input_globals} + 1")
+  endif()
+endforeach()
+
+foreach(LINE ${OUTPUT_LINES})
+  if (LINE MATCHES "^@")
+    math(EXPR output_globals "${output_globals} + 1")
+  elseif (LINE MATCHES "^  [^ ]")
+    math(EXPR instructions "${instructions} + 1")
+  endif()
+
+  if (LINE MATCHES "call void @klee_make_symbolic\\(i8\\*[^,]*, i(32|64) ([0-9]+)")
+    math(EXPR make_symbolic_sites "${make_symbolic_sites} + 1")
+    math(EXPR symbolic_bytes "${symbolic_bytes} + ${CMAKE_MATCH_2}")
+  elseif (LINE MATCHES "call void @klee_make_symbolic\\(")
+    math(EXPR make_symbolic_sites "${make_symbolic_sites} + 1")
+  elseif (LINE MATCHES "call [^@]*@__VERIFIER_malloc0?\\(i(32|64) ([0-9]+)")
+    # the models from memalloc.c make the memory symbolic
+    math(EXPR symbolic_bytes "${symbolic_bytes} + ${CMAKE_MATCH_2}")
+  endif()
+endforeach()
+
+math(EXPR new_globals "${output_globals} - ${input_globals}")
+
+file(READ ${OUTPUT_BC} OUTPUT_HEX HEX)
+string(LENGTH "${OUTPUT_HEX}" output_size)
+math(EXPR output_size "${output_size} / 2")
+
+set(METRICS instructions make_symbolic_sites symbolic_bytes new_globals output_size)
+
+if (UPDATE)
+  set(CONTENT "")
+  foreach(METRIC ${METRICS})
+    set(CONTENT "${CONTENT}set(BASE_${METRIC} ${${METRIC}})\n")
+  endforeach()
+
+  file(WRITE ${BASELINE} "${CONTENT}")
+  message(STATUS "Recorded ${BASELINE}")
+  return()
+endif()
+
+if (NOT EXISTS ${BASELINE})
+  message(FATAL_ERROR "No baseline ${BASELINE}, record it by configuring "
+                      "with -DSVC15_UPDATE_BASELINES=ON and running the test")
+endif()
+
+include(${BASELINE})
+
+set(FAILED "")
+foreach(METRIC ${METRICS})
+  message(STATUS "${METRIC}: ${${METRIC}} (baseline ${BASE_${METRIC}})")
+  if (${METRIC} GREATER BASE_${METRIC})
+    set(FAILED "${FAILED}\n  ${METRIC}: ${${METRIC}} > ${BASE_${METRIC}}")
+  endif()
+endforeach()
+
+if (FAILED)
+  message(FATAL_ERROR "The cost of the prepared code grew:${FAILED}")
+endif()
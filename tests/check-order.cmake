@@ -0,0 +1,44 @@
+# Compile SOURCE, run the PASSES from PLUGIN on it and check that
+# in the output the first line matching FIRST comes before
+# the first line matching SECOND (see CMakeLists.txt)
+
+separate_arguments(PASSES)
+file(MAKE_DIRECTORY ${WORK_DIR})
+
+set(INPUT_BC ${WORK_DIR}/input.bc)
+set(OUTPUT_BC ${WORK_DIR}/output.bc)
+
+macro(run)
+  execute_process(COMMAND ${ARGN} RESULT_VARIABLE RET ERROR_VARIABLE ERR)
+  if (NOT RET EQUAL 0)
+    message(FATAL_ERROR "${ARGN} failed:\n${ERR}")
+  endif()
+endmacro()
+
+run(${CLANG} -c -emit-llvm -O0 ${SOURCE} -o ${INPUT_BC})
+run(${OPT} -load ${PLUGIN} ${PASSES} ${INPUT_BC} -o ${OUTPUT_BC})
+run(${LLVM_DIS} ${OUTPUT_BC} -o ${WORK_DIR}/output.ll)
+
+file(STRINGS ${WORK_DIR}/output.ll OUTPUT_LINES)
+
+set(LINE_NO 0)
+set(FIRST_LINE "")
+set(SECOND_LINE "")
+foreach(LINE ${OUTPUT_LINES})
+  math(EXPR LINE_NO "${LINE_NO} + 1")
+  if (FIRST_LINE STREQUAL "" AND LINE MATCHES "${FIRST}")
+    set(FIRST_LINE ${LINE_NO})
+  endif()
+  if (SECOND_LINE STREQUAL "" AND LINE MATCHES "${SECOND}")
+    set(SECOND_LINE ${LINE_NO})
+  endif()
+endforeach()
+
+if (FIRST_LINE STREQUAL "" OR SECOND_LINE STREQUAL "")
+  message(FATAL_ERROR "'${FIRST}' or '${SECOND}' not found in ${WORK_DIR}/output.ll")
+endif()
+
+if (NOT FIRST_LINE LESS SECOND_LINE)
+  message(FATAL_ERROR "'${FIRST}' (line ${FIRST_LINE}) is not before "
+                      "'${SECOND}' (line ${SECOND_LINE}) in ${WORK_DIR}/output.ll")
+endif()
@@ -0,0 +1,66 @@
+# Compile SOURCE, run the PASSES from PLUGIN on it (or the TOOL with
+# PASSES as arguments) and check that CHECK_FILE (output.ll by default)
+# has a line matching MATCH (if given) and no line matching NOMATCH.
+# The tool must exit with EXIT_CODE (0 by default). %WORK_DIR% in PASSES
+# is replaced by the working directory, so that a pass can write a side
+# file there (see CMakeLists.txt)
+
+string(REPLACE "%WORK_DIR%" "${WORK_DIR}" PASSES "${PASSES}")
+separate_arguments(PASSES)
+file(MAKE_DIRECTORY ${WORK_DIR})
+
+if (NOT DEFINED CHECK_FILE OR CHECK_FILE STREQUAL "")
+  set(CHECK_FILE output.ll)
+endif()
+if (NOT DEFINED EXIT_CODE OR EXIT_CODE STREQUAL "")
+  set(EXIT_CODE 0)
+endif()
+
+set(INPUT_BC ${WORK_DIR}/input.bc)
+set(OUTPUT_BC ${WORK_DIR}/output.bc)
+file(REMOVE ${OUTPUT_BC} ${WORK_DIR}/output.ll)
+
+macro(run)
+  execute_process(COMMAND ${ARGN} RESULT_VARIABLE RET ERROR_VARIABLE ERR)
+  if (NOT RET EQUAL 0)
+    message(FATAL_ERROR "${ARGN} failed:\n${ERR}")
+  endif()
+endmacro()
+
+run(${CLANG} -c -emit-llvm -O0 ${SOURCE} -o ${INPUT_BC})
+
+if (TOOL)
+  set(COMMAND ${TOOL} ${PASSES} ${INPUT_BC} -o ${OUTPUT_BC})
+else()
+  set(COMMAND ${OPT} -load ${PLUGIN} ${PASSES} ${INPUT_BC} -o ${OUTPUT_BC})
+endif()
+
+execute_process(COMMAND ${COMMAND} RESULT_VARIABLE RET ERROR_VARIABLE ERR)
+file(WRITE ${WORK_DIR}/stderr.txt "${ERR}")
+if (NOT RET EQUAL EXIT_CODE)
+  message(FATAL_ERROR "${COMMAND} returned ${RET} (expected ${EXIT_CODE}):\n${ERR}")
+endif()
+
+if (EXISTS ${OUTPUT_BC})
+  run(${LLVM_DIS} ${OUTPUT_BC} -o ${WORK_DIR}/output.ll)
+endif()
+
+if (NOT EXISTS ${WORK_DIR}/${CHECK_FILE})
+  message(FATAL_ERROR "${WORK_DIR}/${CHECK_FILE} was not created")
+endif()
+
+file(STRINGS ${WORK_DIR}/${CHECK_FILE} LINES)
+
+set(FOUND FALSE)
+foreach(LINE ${LINES})
+  if (LINE MATCHES "${MATCH}")
+    set(FOUND TRUE)
+  endif()
+  if (NOMATCH AND LINE MATCHES "${NOMATCH}")
+    message(FATAL_ERROR "'${NOMATCH}' found in ${WORK_DIR}/${CHECK_FILE}:\n${LINE}")
+  endif()
+endforeach()
+
+if (NOT MATCH STREQUAL "" AND NOT FOUND)
+  message(FATAL_ERROR "'${MATCH}' not found in ${WORK_DIR}/${CHECK_FILE}")
+endif()
@@ -0,0 +1,23 @@
+extern int __VERIFIER_nondet_int(void);
+extern void __VERIFIER_error(void);
+extern void __VERIFIER_assume(int);
+
+int main(void)
+{
+	int x = __VERIFIER_nondet_int();
+	int flag = __VERIFIER_nondet_int();
+	int y;
+
+	/* klee forks here, the assume should be moved above the branch */
+	if (flag)
+		y = 1;
+	else
+		y = 2;
+
+	__VERIFIER_assume(x > 0);
+
+	if (x <= 0)
+		__VERIFIER_error();
+
+	return y;
+}
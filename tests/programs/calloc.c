@@ -0,0 +1,16 @@
+extern void *calloc(unsigned long, unsigned long);
+extern void free(void *);
+extern void __VERIFIER_error(void);
+
+int main(void)
+{
+	int *arr = calloc(4096, sizeof(int));
+	if (!arr)
+		return 0;
+
+	if (arr[1000] != 0)
+		__VERIFIER_error();
+
+	free(arr);
+	return 0;
+}
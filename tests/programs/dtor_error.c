@@ -0,0 +1,15 @@
+extern void __VERIFIER_error(void);
+
+int flag;
+
+__attribute__((destructor)) static void check_flag(void)
+{
+	if (flag)
+		__VERIFIER_error();
+}
+
+int main(void)
+{
+	flag = 1;
+	return 0;
+}
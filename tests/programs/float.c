@@ -0,0 +1,20 @@
+extern float __VERIFIER_nondet_float(void);
+extern double __VERIFIER_nondet_double(void);
+extern void __VERIFIER_error(void);
+
+int main(void)
+{
+	float f = __VERIFIER_nondet_float();
+	double d = __VERIFIER_nondet_double();
+	double r;
+
+	if (f > 1.0f && f < 2.0f)
+		r = d * f;
+	else
+		r = d;
+
+	if (r != r)
+		__VERIFIER_error();
+
+	return 0;
+}
@@ -0,0 +1,19 @@
+extern int __VERIFIER_nondet_int(void);
+extern void __VERIFIER_error(void);
+
+int main(void)
+{
+	int x = __VERIFIER_nondet_int();
+	int y;
+
+	/* clamp, klee would fork on it */
+	if (x > 10)
+		y = 10;
+	else
+		y = x;
+
+	if (y > 10)
+		__VERIFIER_error();
+
+	return 0;
+}
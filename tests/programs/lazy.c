@@ -0,0 +1,19 @@
+extern void __VERIFIER_error(void);
+
+/* not called, kept by -keep=helper */
+int helper(int x)
+{
+	return x + 1;
+}
+
+void unused(void)
+{
+	__VERIFIER_error();
+}
+
+void unused_alias(void) __attribute__((alias("unused")));
+
+int main(void)
+{
+	return 0;
+}
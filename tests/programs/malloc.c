@@ -0,0 +1,29 @@
+extern void *malloc(unsigned long);
+extern void *memset(void *, int, unsigned long);
+extern void free(void *);
+extern void __VERIFIER_error(void);
+
+struct node {
+	int value;
+	struct node *next;
+};
+
+int main(void)
+{
+	struct node *n = malloc(sizeof *n);
+	if (!n)
+		return 0;
+
+	/* overwritten before it is read */
+	char *buf = malloc(64);
+	if (!buf)
+		return 0;
+	memset(buf, 0, 64);
+
+	if (n->value == 42 && buf[0] != 0)
+		__VERIFIER_error();
+
+	free(buf);
+	free(n);
+	return 0;
+}
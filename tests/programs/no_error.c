@@ -0,0 +1,13 @@
+extern void __VERIFIER_error(void);
+
+/* never called */
+void check(int x)
+{
+	if (x < 0)
+		__VERIFIER_error();
+}
+
+int main(void)
+{
+	return 0;
+}
@@ -0,0 +1,20 @@
+extern int __VERIFIER_nondet_int(void);
+extern unsigned int __VERIFIER_nondet_uint(void);
+extern void __VERIFIER_error(void);
+extern void __VERIFIER_assume(int);
+
+int main(void)
+{
+	int x = __VERIFIER_nondet_int();
+	unsigned int n = __VERIFIER_nondet_uint();
+	__VERIFIER_assume(n < 10);
+
+	int sum = 0;
+	for (unsigned int i = 0; i < n; ++i)
+		sum += x;
+
+	if (x > 0 && sum < 0)
+		__VERIFIER_error();
+
+	return 0;
+}
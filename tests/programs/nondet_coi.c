@@ -0,0 +1,19 @@
+extern int __VERIFIER_nondet_int(void);
+extern unsigned int __VERIFIER_nondet_uint(void);
+extern void __VERIFIER_error(void);
+
+int main(void)
+{
+	int x = __VERIFIER_nondet_int();
+	/* can not influence the error */
+	unsigned int y = __VERIFIER_nondet_uint();
+	int *p = &x;
+
+	y = y + 1;
+
+	/* read through a loaded pointer, x escaped into p */
+	if (*p > 0)
+		__VERIFIER_error();
+
+	return 0;
+}
@@ -0,0 +1,16 @@
+extern void *__VERIFIER_nondet_pointer(void);
+extern void __VERIFIER_error(void);
+
+int main(void)
+{
+	int a = 0, b = 0;
+	int *p = __VERIFIER_nondet_pointer();
+
+	if (p == &a || p == &b)
+		*p = 1;
+
+	if (a && b)
+		__VERIFIER_error();
+
+	return 0;
+}
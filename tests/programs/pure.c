@@ -0,0 +1,16 @@
+extern int __VERIFIER_nondet_int(void);
+extern void __VERIFIER_error(void);
+
+/* undefined, but without side effects (readnone) */
+extern int hash(int) __attribute__((const));
+
+int main(void)
+{
+	int x = __VERIFIER_nondet_int();
+	int y = __VERIFIER_nondet_int();
+
+	if (x == y && hash(x) != hash(y))
+		__VERIFIER_error();
+
+	return 0;
+}
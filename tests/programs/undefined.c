@@ -0,0 +1,15 @@
+extern int get_value(int);
+extern void log_message(const char *);
+extern void __VERIFIER_error(void);
+
+int main(void)
+{
+	int a = get_value(1);
+	int b = get_value(1);
+
+	log_message("checking");
+	if (a != b)
+		__VERIFIER_error();
+
+	return 0;
+}
@@ -0,0 +1,16 @@
+extern void __VERIFIER_error(void);
+
+int main(void)
+{
+	int arr[128];
+	char buf[16];
+	int i;
+
+	for (i = 0; i < 16; ++i)
+		buf[i] = 0;
+
+	if (arr[5] == 7 && buf[3] == 0)
+		__VERIFIER_error();
+
+	return 0;
+}
@@ -0,0 +1,12 @@
+extern void __VERIFIER_error(void);
+
+int main(void)
+{
+	/* two different uninitialized values */
+	int x, y;
+
+	if (x != y)
+		__VERIFIER_error();
+
+	return 0;
+}
@@ -0,0 +1,24 @@
+extern void __VERIFIER_error(void);
+
+struct small {
+	char c;
+	int i;
+};
+
+struct large {
+	char tag;
+	long values[8];
+	short flags;
+};
+
+int main(void)
+{
+	struct small s;
+	struct large l;
+	int x;
+
+	if (s.i > x && l.values[3] == l.flags)
+		__VERIFIER_error();
+
+	return 0;
+}